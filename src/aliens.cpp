@@ -5,10 +5,12 @@
 #include "aliens.h"
 
 #include "engine.h"
-#include "screen.h"
+#include "font.h"
+#include "playfield.h"
 #include "turret.h"
 
 #include <algorithm>
+#include <bit>
 
 namespace {
 
@@ -28,36 +30,42 @@ namespace {
 
 }  // namespace
 
-aliens::aliens(screen& screen)
-    : _screen{screen}
+glyph_set aliens::glyphs()
+{
+    auto glyphs = glyph_set{};
+    glyphs.add(alien_sprites_1);
+    glyphs.add(alien_sprites_2);
+    glyphs.add(explosion_sprite);
+    return glyphs;
+}
+
+aliens::aliens(playfield& playfield)
+    : _playfield{playfield}
 {
 }
 
 void aliens::reset()
 {
-    _y_delta = 0;
-    _x_delta = 1;
-    _reverse = false;
-    _killed_instance = nullptr;
-    _killed_timer = 0;
-    _killed_count = 0;
-    _last_moved = -1;
-    _horizontal_offset = 10;
-    _best_shooter_column = 0;
-    _shooter_count = 0;
-    _shot_count = 0;
-    _landed = false;
-    std::fill(_shooters.begin(), _shooters.end(), nullptr);
+    _state.y_delta = 0;
+    _state.x_delta = 1;
+    _state.reverse = false;
+    _state.killed_id = -1;
+    _state.killed_timer = 0;
+    _state.killed_count = 0;
+    _state.last_moved = -1;
+    _state.horizontal_offset = 10;
+    _state.best_shooter_column = 0;
+    _state.shot_count = 0;
+    _state.landed = false;
+    _state.alive_mask = 0;
+    _state.column_masks = {};
+    _state.shooter_columns = 0;
 }
 
 bool aliens::init(const int frame, const int level)
 {
-    if (frame < _aliens.size()) {
-        _aliens[frame].init(frame, level, _screen);
-        if (frame < _shooters.size()) {
-            _shooters[frame] = &_aliens[frame];
-            _shooter_count++;
-        }
+    if (frame < count) {
+        _init(frame, level);
         return false;
     }
     return true;
@@ -65,55 +73,52 @@ bool aliens::init(const int frame, const int level)
 
 int aliens::update(const turret& turret)
 {
-    const auto just_killed = (_killed_timer == 16);
-    if (_killed_timer > 0) {
-        if (--_killed_timer == 0) {
-            _killed_instance->hide(_screen);
-            _killed_count++;
+    const auto just_killed = (_state.killed_timer == 16);
+    if (_state.killed_timer > 0) {
+        if (--_state.killed_timer == 0) {
+            _hide(_state.killed_id);
+            _state.killed_count++;
         }
-    } else if (!_landed && !turret.exploding()) {
-        auto current = _last_moved;
-        do {
-            current = (current + 1) % _aliens.size();
-        } while (_aliens[current].dead());
+    } else if (!_state.landed && !turret.exploding()) {
+        const auto current = _next_alive(_state.last_moved);
 
         // If the current alien is less than the last one we moved, that means
         // we're starting a new cycle, and may need to reverse direction. We
         // also take this opportunity to update the horizontal offset of the
         // group, which is used to calculate which column is best positioned
         // to fire at the laser turret.
-        if (current <= _last_moved) {
-            _horizontal_offset = _aliens[current].x() - current * 4;
-            _y_delta = 0;
-            if (_reverse) {
-                _x_delta = -_x_delta;
-                _y_delta = 1;
+        if (current <= _state.last_moved) {
+            _state.horizontal_offset = _state.x[current] - current * 4;
+            _state.y_delta = 0;
+            if (_state.reverse) {
+                _state.x_delta = -_state.x_delta;
+                _state.y_delta = 1;
             }
-            _reverse = false;
+            _state.reverse = false;
         }
 
         // If the current alien is already on the turret row before we've even
         // moved it, it's safe to conclude that the aliens have landed.
         // Otherwise we'll only trigger a landing when moving an alien onto the
         // turret row while also being right of the turret position.
-        if (_aliens[current].y() == turret::row)
-            _landed = true;
+        if (_state.y[current] == turret::row)
+            _state.landed = true;
         else {
-            if (_aliens[current].update(_y_delta, _x_delta, _screen))
-                _reverse = true;
-            if (_aliens[current].y() == turret::row && _aliens[current].x() >= turret.x())
-                _landed = true;
+            if (_move(current, _state.y_delta, _state.x_delta))
+                _state.reverse = true;
+            if (_state.y[current] == turret::row && _state.x[current] >= turret.x())
+                _state.landed = true;
         }
 
-        _last_moved = current;
+        _state.last_moved = current;
     }
-    _best_shooter_column = std::clamp((turret.x() - _horizontal_offset) / 4, 0, columns - 1);
-    return just_killed ? _killed_instance->points() : 0;
+    _state.best_shooter_column = std::clamp((turret.x() - _state.horizontal_offset) / 4, 0, columns - 1);
+    return just_killed ? (_state.type[_state.killed_id] + 1) * 10 : 0;
 }
 
 bool aliens::can_fire() const
 {
-    return _shooter_count > 0;
+    return _state.shooter_columns != 0;
 }
 
 std::pair<int, int> aliens::fire()
@@ -124,127 +129,132 @@ std::pair<int, int> aliens::fire()
     // with the next position in the series.
     auto column = 0;
     do {
-        column = shoot_order[_shot_count] - 1;
-        _shot_count = (_shot_count + 1) % shoot_order.size();
+        column = shoot_order[_state.shot_count] - 1;
+        _state.shot_count = (_state.shot_count + 1) % shoot_order.size();
         if (column < 0) {
-            column = _best_shooter_column;
-            if (column >= _shooters.size()) column = -1;
+            column = _state.best_shooter_column;
+            if (column >= columns) column = -1;
         }
-    } while (column < 0 || _shooters[column] == nullptr);
+    } while (column < 0 || _state.column_masks[column] == 0);
 
-    const auto shooter = *_shooters[column];
-    return std::make_pair(shooter.y() + 1, shooter.x() + 1);
+    const auto shooter = _shooter(column);
+    return std::make_pair(_state.y[shooter] + 1, _state.x[shooter] + 1);
 }
 
 void aliens::kill(const int id)
 {
-    _killed_timer = 16;
-    _killed_instance = &_aliens[id];
-    _killed_instance->kill(_screen);
+    // Once an alien is no longer alive, the next one up in its column (if
+    // any) automatically becomes the shooter.
+    _state.killed_timer = 16;
+    _state.killed_id = id;
+    _state.alive_mask &= ~(std::uint64_t{1} << id);
     const auto column = id % columns;
-    if (_shooters[column] == _killed_instance) {
-        auto id_above = id + columns;
-        while (id_above < _aliens.size() && _aliens[id_above].dead())
-            id_above += columns;
-        _shooters[column] = (id_above < _aliens.size() ? &_aliens[id_above] : nullptr);
-        if (!_shooters[column]) _shooter_count--;
-    }
+    _state.column_masks[column] &= ~(1 << (id / columns));
+    if (_state.column_masks[column] == 0)
+        _state.shooter_columns &= ~(1 << column);
+    _render(id);
 }
 
 bool aliens::exploding() const
 {
-    return _killed_timer > 0;
+    return _state.killed_timer > 0;
 }
 
 bool aliens::landed() const
 {
-    return _landed;
+    return _state.landed;
 }
 
 int aliens::remaining() const
 {
-    return count - _killed_count;
+    return count - _state.killed_count;
 }
 
-void aliens::instance::init(const int id, const int level, screen& screen)
+void aliens::_init(const int id, const int level)
 {
     constexpr auto y_offsets = std::to_array({11, 14, 16, 17});
     const auto y_offset = y_offsets[std::min(level, 3)];
     const auto x_offset = 10;
-    const auto row = id / 11;
-    const auto col = id % 11;
-    _y = y_offset - row * 2;
-    _x = x_offset + col * 4;
-    _id = id;
-    _type = row / 2;
-    _dead = false;
-    if (col != 0)
-        screen.write(_y, _x - 1, ' ');
-    _render(screen);
+    const auto row = id / columns;
+    const auto column = id % columns;
+    _state.y[id] = y_offset - row * 2;
+    _state.x[id] = x_offset + column * 4;
+    _state.type[id] = static_cast<std::uint8_t>(row / 2);
+    _state.alive_mask |= std::uint64_t{1} << id;
+    _state.column_masks[column] |= 1 << row;
+    _state.shooter_columns |= 1 << column;
+    if (column != 0)
+        _playfield.write(_state.y[id], _state.x[id] - 1, ' ');
+    _render(id);
 }
 
-bool aliens::instance::update(const int y_delta, const int x_delta, screen& screen)
+bool aliens::_move(const int id, const int y_delta, const int x_delta)
 {
+    auto& y = _state.y[id];
+    auto& x = _state.x[id];
     if (y_delta) {
-        screen.write(_y, _x, "   ");
-        _y += y_delta;
-        _x += x_delta;
-        _render(screen);
+        _playfield.write(y, x, "   ");
+        y += y_delta;
+        x += x_delta;
+        _render(id);
     } else if (x_delta > 0) {
-        screen.write(_y, _x, ' ');
-        _x++;
-        _render(screen);
+        _playfield.write(y, x, ' ');
+        x++;
+        _render(id);
     } else if (x_delta < 0) {
-        _x--;
-        _render(screen);
-        screen.write(_y, _x + 3, ' ');
+        x--;
+        _render(id);
+        _playfield.write(y, x + 3, ' ');
     }
     // We return true to indicate when we've reached one of the boundaries,
     // and the group will then need to reverse direction on the next cycle.
-    return _x <= 1 || _x + 2 >= engine::width;
+    return x <= 1 || x + 2 >= engine::width;
 }
 
-void aliens::instance::hide(screen& screen)
+void aliens::_hide(const int id)
 {
-    screen.write(_y, _x, "   ");
+    _playfield.write(_state.y[id], _state.x[id], "   ");
 }
 
-void aliens::instance::kill(screen& screen)
+void aliens::_render(const int id)
 {
-    _dead = true;
-    _render(screen);
+    const auto y = _state.y[id];
+    const auto x = _state.x[id];
+    const auto color = playfield::color_for_row(y);
+    if (!_alive(id))
+        _playfield.write(y, x, explosion_sprite, color, explosion_id);
+    else if (y == turret::row)
+        _playfield.write(y, x, landed_sprite, color);
+    else if (x % 2 == 0)
+        _playfield.write(y, x, alien_sprites_1[_state.type[id]], color, id);
+    else
+        _playfield.write(y, x, alien_sprites_2[_state.type[id]], color, id);
 }
 
-int aliens::instance::points() const
+int aliens::_next_alive(const int id) const
 {
-    return (_type + 1) * 10;
+    // The next living alien after the given id, wrapping around to the
+    // start of the formation if there are none left after it.
+    const auto after = id + 1 < 64 ? _state.alive_mask & (~std::uint64_t{0} << (id + 1)) : 0;
+    return std::countr_zero(after ? after : _state.alive_mask);
 }
 
-int aliens::instance::y() const
+int aliens::_shooter(const int column) const
 {
-    return _y;
+    return std::countr_zero(_state.column_masks[column]) * columns + column;
 }
 
-int aliens::instance::x() const
+bool aliens::_alive(const int id) const
 {
-    return _x;
+    return (_state.alive_mask >> id) & 1;
 }
 
-
-bool aliens::instance::dead() const
+aliens::state aliens::save() const
 {
-    return _dead;
+    return _state;
 }
 
-void aliens::instance::_render(screen& screen)
+void aliens::restore(const state& state)
 {
-    const auto color = screen::color_for_row(_y);
-    if (_dead)
-        screen.write(_y, _x, explosion_sprite, color, explosion_id);
-    else if (_y == turret::row)
-        screen.write(_y, _x, landed_sprite, color);
-    else if (_x % 2 == 0)
-        screen.write(_y, _x, alien_sprites_1[_type], color, _id);
-    else
-        screen.write(_y, _x, alien_sprites_2[_type], color, _id);
+    _state = state;
 }
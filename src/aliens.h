@@ -5,9 +5,11 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <tuple>
 
-class screen;
+class glyph_set;
+class playfield;
 class turret;
 
 class aliens {
@@ -16,7 +18,34 @@ public:
     static constexpr int count = 5 * columns;
     static constexpr int explosion_id = 'E';
 
-    aliens(screen& screen);
+    struct state {
+        int y_delta = 0;
+        int x_delta = 1;
+        bool reverse = false;
+        int killed_id = -1;
+        int killed_timer = 0;
+        int killed_count = 0;
+        int last_moved = -1;
+        int horizontal_offset = 0;
+        int best_shooter_column = 0;
+        int shot_count = 0;
+        bool landed = false;
+
+        // The formation is stored as separate arrays indexed by alien id,
+        // with the ids of the living aliens tracked as bits in a mask. Each
+        // column also has a mask of its living aliens, indexed by row, so the
+        // lowest set bit identifies the column's shooter.
+        std::array<int, count> y = {};
+        std::array<int, count> x = {};
+        std::array<std::uint8_t, count> type = {};
+        std::uint64_t alive_mask = 0;
+        std::array<std::uint8_t, columns> column_masks = {};
+        std::uint16_t shooter_columns = 0;
+    };
+
+    static glyph_set glyphs();
+
+    aliens(playfield& playfield);
     void reset();
     bool init(const int frame, const int level);
     int update(const turret& turret);
@@ -26,42 +55,21 @@ public:
     bool exploding() const;
     bool landed() const;
     int remaining() const;
+    state save() const;
+    void restore(const state& state);
 
 private:
-    class instance {
-    public:
-        void init(const int id, const int level, screen& screen);
-        bool update(const int y_delta, const int x_delta, screen& screen);
-        void hide(screen& screen);
-        void kill(screen& screen);
-        int points() const;
-        int y() const;
-        int x() const;
-        bool dead() const;
-
-    private:
-        void _render(screen& screen);
+    static constexpr int rows = count / columns;
+    static_assert(count <= 64, "the alive mask must fit in 64 bits");
 
-        int _id = 0;
-        int _y = 0;
-        int _x = 0;
-        int _type = 0;
-        bool _dead = false;
-    };
+    void _init(const int id, const int level);
+    bool _move(const int id, const int y_delta, const int x_delta);
+    void _hide(const int id);
+    void _render(const int id);
+    int _next_alive(const int id) const;
+    int _shooter(const int column) const;
+    bool _alive(const int id) const;
 
-    screen& _screen;
-    int _y_delta = 0;
-    int _x_delta = 1;
-    bool _reverse = false;
-    instance* _killed_instance = nullptr;
-    int _killed_timer = 0;
-    int _killed_count = 0;
-    int _last_moved = -1;
-    int _horizontal_offset = 0;
-    int _best_shooter_column = 0;
-    int _shooter_count = 0;
-    int _shot_count = 0;
-    bool _landed = false;
-    std::array<instance, count> _aliens = {};
-    std::array<instance*, columns> _shooters = {};
+    playfield& _playfield;
+    state _state;
 };
@@ -0,0 +1,90 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "allocations.h"
+
+#include "output.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+    // The count is per thread, so we're only measuring allocations made by
+    // the game loop itself, and not anything happening in the background.
+    thread_local long long allocation_count = 0;
+    long long frame_count = 0;
+    long long allocating_frame_count = 0;
+    long long frame_allocation_count = 0;
+
+}  // namespace
+
+#ifdef VTINVADERS_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size)
+{
+    allocation_count++;
+    if (auto p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#endif
+
+bool allocations::counting()
+{
+#ifdef VTINVADERS_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+long long allocations::count()
+{
+    return allocation_count;
+}
+
+void allocations::end_frame(const long long start_count)
+{
+    const auto allocated = allocation_count - start_count;
+    frame_count++;
+    if (allocated > 0) {
+        allocating_frame_count++;
+        frame_allocation_count += allocated;
+    }
+}
+
+void allocations::report(output& out)
+{
+    if (counting()) {
+        out << "Frames: " << static_cast<int>(frame_count);
+        out << ", frames that allocated: " << static_cast<int>(allocating_frame_count);
+        out << ", allocations: " << static_cast<int>(frame_allocation_count) << '\n';
+    }
+}
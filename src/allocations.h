@@ -0,0 +1,15 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+class output;
+
+class allocations {
+public:
+    static bool counting();
+    static long long count();
+    static void end_frame(const long long start_count);
+    static void report(output& out);
+};
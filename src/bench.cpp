@@ -0,0 +1,56 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "bench.h"
+
+#include "capabilities.h"
+#include "engine.h"
+#include "input.h"
+#include "options.h"
+#include "output.h"
+#include "pacer.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+int run_benchmark(const options& options)
+{
+    using clock = std::chrono::steady_clock;
+
+    // The game output is only counted, never written anywhere, so the
+    // results don't depend on the speed of a terminal.
+    auto game_sink = null_sink{};
+    auto game_out = output{game_sink};
+    auto input = input_queue{};
+    const auto caps = capabilities::synthetic(game_out, input);
+    auto source = scripted_input{options.bench_frames};
+    auto frame_pacer = pacer{options.fps, false};
+    auto game_stats = stats{options.fps};
+
+    const auto cpu_start = std::clock();
+    const auto wall_start = clock::now();
+    while (true) {
+        auto game_engine = engine{caps, options, game_out, source, input, frame_pacer, game_stats};
+        if (!game_engine.run()) break;
+    }
+    game_out.flush();
+    const auto wall_time = clock::now() - wall_start;
+    const auto cpu_time = std::clock() - cpu_start;
+
+    const auto frames = game_stats.frame_count();
+    const auto wall_us = std::chrono::duration_cast<std::chrono::microseconds>(wall_time).count();
+    const auto cpu_ms = static_cast<long long>(cpu_time) * 1000 / CLOCKS_PER_SEC;
+    auto stdout_sink = fd_sink{1};
+    auto out = output{stdout_sink};
+    out << "Benchmark: " << static_cast<int>(frames) << " frames";
+    out << ", " << static_cast<int>(frames * 1'000'000 / std::max<long long>(wall_us, 1)) << " frames/sec";
+    out << ", CPU time (ms) " << static_cast<int>(cpu_ms) << '\n';
+    out << "Output: " << static_cast<int>(game_sink.bytes_written()) << " bytes\n";
+    game_stats.report_frames(out);
+    game_stats.report_output(out);
+    out.flush();
+    return 0;
+}
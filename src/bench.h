@@ -0,0 +1,12 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+class options;
+
+// Runs the game headless for a fixed number of frames, with a synthetic
+// terminal profile, scripted input, and no frame pacing, and then reports
+// the throughput and the output cost per frame.
+int run_benchmark(const options& options);
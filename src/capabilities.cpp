@@ -5,143 +5,264 @@
 #include "capabilities.h"
 
 #include "os.h"
+#include "output.h"
+#include "parser.h"
 
-#include <cstring>
-#include <iostream>
+#include <cstdio>
+#include <fstream>
+#include <span>
 
-using namespace std::string_literals;
+using namespace std::chrono_literals;
 
-capabilities::capabilities()
+namespace {
+
+    // How long we'll wait for the terminal to answer the startup queries
+    // before giving up and falling back to the defaults.
+    constexpr auto query_timeout = 3s;
+
+}  // namespace
+
+capabilities::capabilities(output& output, input_queue& input)
+    : _output{output}, _input{input}
 {
+    // The queries are sent in batches, so we only have to wait for one
+    // round-trip per batch. Each batch ends with a DA request, and since
+    // every terminal answers that, it tells us when the other responses are
+    // done. Any query that isn't supported is simply left unanswered.
+
     // Save the cursor position.
-    std::cout << "\0337";
+    _output << "\0337";
     // Request 7-bit C1 controls from the terminal.
-    std::cout << "\033 F";
+    _output << "\033 F";
     // Determine the screen size.
-    std::cout << "\033[999;999H";
-    const auto size = query_cursor_position();
-    if (size) std::tie(height, width) = size.value();
+    _output << "\033[999;999H\033[6n";
+    // Restore the cursor position.
+    _output << "\0338";
+    // Retrieve the terminal id so we can guess the font size.
+    _output << "\033[>c";
+    // Save the modes and settings that we're going to change. These are the
+    // user's current settings, so they're queried on every launch.
+    _output << "\033[?5$p";
+    _output << "\033[?7$p";
+    _output << "\033P$q$~\033\\";
+    // Save the color assignment and color table.
+    _output << "\033P$q1,|\033\\";
+    _output << "\033[2;2$u";
+    // Retrieve the device attributes report.
+    _output << "\033[c";
+    if (!_receive_reports()) return;
+
+    // The DA reports identify the terminal, and they also give us the
+    // conformance level, the feature extensions, and the terminal id that
+    // the font size is chosen from. All that's left to probe is support for
+    // 8-bit controls. If we've seen this terminal before, that is taken from
+    // the cached profile instead, which saves a round trip.
+    const auto profile_key = _profile_key();
+    if (_load_profile(profile_key)) return;
+
     // Check if 8-bit controls are supported.
-    std::cout << "\0338\2335n\033[1K";
-    has_8bit = !_query(R"(\x1B\[\d*n)", true).empty();
+    _output << "\2335n\033[1K";
     // Retrieve the device attributes report.
-    _query_device_attributes();
-    // Retrieve the terminal id so we can guess the font size.
-    _query_terminal_id();
+    _output << "\033[c";
     // Restore the cursor position.
-    std::cout << "\0338";
+    _output << "\0338";
+    if (_receive_reports())
+        _save_profile(profile_key);
 }
 
-std::optional<std::pair<int, int>> capabilities::query_cursor_position() const
+capabilities::capabilities(output& output, input_queue& input, unprobed)
+    : _output{output}, _input{input}
 {
-    std::cout << "\033[6n";
-    const auto pos = _query(R"(\x1B\[(\d+);(\d+)R)", false);
-    if (pos.empty()) return {};
-    return std::make_pair(std::stoi(pos[1]), std::stoi(pos[2]));
 }
 
-std::optional<bool> capabilities::query_mode(const int mode) const
+capabilities capabilities::synthetic(output& output, input_queue& input)
 {
-    std::cout << "\033[?" << mode << "$p";
-    const auto report = _query(R"(\x1B\[\?(\d+);(\d+)\$y)", true);
-    if (!report.empty()) {
-        const auto returned_mode = std::stoi(report[1]);
-        const auto status = std::stoi(report[2]);
-        if (returned_mode == mode) {
-            if (status == 1) return true;
-            if (status == 2) return false;
+    // A fixed VT525-like profile, without any queries, so the benchmark
+    // exercises the same code paths regardless of where it's run.
+    auto caps = capabilities{output, input, unprobed{}};
+    caps.width = 80;
+    caps.height = 24;
+    caps.has_soft_fonts = true;
+    caps.has_color = true;
+    caps.has_8bit = true;
+    caps.conformance_level = 5;
+    caps.terminal_id = 65;
+    return caps;
+}
+
+bool capabilities::wait_until_ready(const std::chrono::milliseconds allowance) const
+{
+    // A DA report tells us the terminal has processed everything sent before
+    // it. The allowance extends the deadline for output that is expected to
+    // take a while to transmit.
+    _output << "\033[c";
+    _output.flush();
+    auto reports = parser{_input};
+    const auto deadline = clock::now() + query_timeout + allowance;
+    for (;;) {
+        const auto report = _read_report(reports, deadline);
+        if (!report) return false;
+        if (report->type == report_type::da1) return true;
+    }
+}
+
+bool capabilities::_parse_report(const report& report)
+{
+    // Returns true once the DA report has been received, since that marks
+    // the end of the responses.
+    switch (report.type) {
+        case report_type::da1:
+            _parse_device_attributes(report);
+            _da1_params.assign(report.params.begin(), report.params.end());
+            return true;
+        case report_type::cpr:
+            height = report.param(0, 1);
+            width = report.param(1, 1);
+            break;
+        case report_type::dsr:
+            has_8bit = true;
+            break;
+        case report_type::da2:
+            terminal_id = report.param(0);
+            _da2_params.assign(report.params.begin(), report.params.end());
+            break;
+        case report_type::decrpm: {
+            const auto mode = report.param(0);
+            const auto status = report.param(1);
+            auto value = std::optional<bool>{};
+            if (status == 1) value = true;
+            if (status == 2) value = false;
+            if (mode == 5) original_decscnm = value;
+            if (mode == 7) original_decawm = value;
+            break;
         }
+        case report_type::decrqss:
+            // The settings are identified by the final characters of the report.
+            if (report.param(0) != 1) break;
+            if (report.data.ends_with("$~"))
+                original_decssdt = report.data;
+            else if (report.data.ends_with(",|"))
+                original_color_assignment = report.data;
+            break;
+        case report_type::decctr:
+            if (report.param(0) == 2)
+                original_color_table = report.data;
+            break;
     }
-    return {};
+    return false;
 }
 
-std::string capabilities::query_setting(const std::string_view setting) const
+void capabilities::_parse_device_attributes(const report& report)
 {
-    std::cout << "\033P$q" << setting << "\033\\";
-    const auto report = _query(R"(\x1BP1\$r(.*)\x1B\\)", true);
-    if (!report.empty())
-        return report[1];
-    else
-        return {};
+    // The first parameter indicates the terminal conformance level.
+    // The remaining parameters indicate additional feature extensions.
+    const auto level = report.param(0);
+    if (level > 60) conformance_level = level - 60;
+    for (auto i = 1u; i < report.params.size(); i++) {
+        switch (report.params[i]) {
+            case 7: has_soft_fonts = true; break;
+            case 22: has_color = true; break;
+        }
+    }
 }
 
-std::string capabilities::query_color_table() const
+bool capabilities::_receive_reports()
 {
-    std::cout << "\033[2;2$u";
-    const auto report = _query(R"(\x1BP2\$s(.*)\x1B\\)", true);
-    if (!report.empty())
-        return report[1];
-    else
-        return {};
+    // Returns false if the deadline passed before the DA report arrived.
+    _output.flush();
+    auto reports = parser{_input};
+    const auto deadline = clock::now() + query_timeout;
+    for (;;) {
+        const auto report = _read_report(reports, deadline);
+        if (!report) return false;
+        if (_parse_report(*report)) return true;
+    }
 }
 
-void capabilities::_query_device_attributes()
+std::string capabilities::_profile_key() const
 {
-    std::cout << "\033[c";
-    // The Reflection Desktop terminal sometimes uses comma separators
-    // instead of semicolons in their DA report, so we allow for either.
-    const auto report = _query(R"(\x1B\[\?(\d+)([;,\d]*)c)", false);
-    if (!report.empty()) {
-        // The first parameter indicates the terminal conformance level.
-        // The remaining parameters indicate additional feature extensions.
-        const auto features = report[2].str();
-        const auto digits = std::regex(R"(\d+)");
-        auto it = std::sregex_iterator(features.begin(), features.end(), digits);
-        while (it != std::sregex_iterator()) {
-            const auto feature = std::stoi(it->str());
-            switch (feature) {
-                case 7: has_soft_fonts = true; break;
-                case 22: has_color = true; break;
-            }
-            it++;
+    // Profiles are identified by the terminal type and device, along with
+    // the content of the DA1 and DA2 reports.
+    auto key = std::string{};
+    const auto add_params = [&](const auto prefix, const auto& params) {
+        key += prefix;
+        for (auto i = 0u; i < params.size(); i++) {
+            if (i) key += ';';
+            key += std::to_string(params[i]);
         }
+    };
+    key += os::terminal_type();
+    key += ' ';
+    key += os::terminal_name();
+    add_params(" DA1=", _da1_params);
+    add_params(" DA2=", _da2_params);
+    return key;
+}
+
+bool capabilities::_load_profile(const std::string& key)
+{
+    auto file = std::ifstream{_profile_path(key)};
+    auto line = std::string{};
+    if (!std::getline(file, line) || line != "key=" + key) return false;
+    while (std::getline(file, line)) {
+        const auto separator = line.find('=');
+        if (separator == std::string::npos) continue;
+        const auto name = std::string_view{line}.substr(0, separator);
+        const auto value = line.substr(separator + 1);
+        if (name == "has_8bit") has_8bit = value == "1";
     }
+    return true;
 }
 
-void capabilities::_query_terminal_id()
+void capabilities::_save_profile(const std::string& key) const
 {
-    std::cout << "\033[>c";
-    const auto report = _query(R"(\x1B\[>(\d+)[;\d]*c)", true);
-    if (!report.empty()) {
-        terminal_id = std::stoi(report[1]);
+    const auto path = _profile_path(key);
+    if (path.empty()) return;
+    // The format is line based, so a key containing a line break can't be
+    // saved (not that we'd expect that from a valid terminal name).
+    if (key.find_first_of("\r\n") != std::string::npos) return;
+    auto error = std::error_code{};
+    std::filesystem::create_directories(path.parent_path(), error);
+    // The profile is written to a temporary file first, and then renamed,
+    // so a concurrent launch can never see a partially written profile.
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        auto file = std::ofstream{temp_path, std::ios::trunc};
+        file << "key=" << key << '\n';
+        file << "has_8bit=" << has_8bit << '\n';
+        if (!file.flush()) return;
     }
+    std::filesystem::rename(temp_path, path, error);
 }
 
-std::smatch capabilities::_query(const char* pattern, const bool may_not_work)
+std::filesystem::path capabilities::_profile_path(const std::string& key)
 {
-    auto final_char = pattern[strlen(pattern) - 1];
-    if (may_not_work) {
-        // If we're uncertain this query is supported, we'll send an extra DA
-        // or DSR-CPR query to make sure that we get some kind of response.
-        if (final_char == 'R') {
-            final_char = 'c';
-            std::cout << "\033[c";
-        } else {
-            final_char = 'R';
-            std::cout << "\033[6n";
-        }
+    // The file name is an FNV-1a hash of the key. The key itself is stored
+    // in the file, so a collision just means a cache miss.
+    auto path = os::cache_path();
+    if (path.empty()) return {};
+    auto hash = 14695981039346656037ull;
+    for (const auto ch : key) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
     }
-    std::cout.flush();
-    // This needs to be static so the returned smatch can reference it.
-    static auto response = std::string{};
-    response.clear();
-    auto last_escape = 0;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", hash);
+    return path / "profiles" / name;
+}
+
+const report* capabilities::_read_report(parser& parser, const clock::time_point deadline)
+{
+    // Returns the next report from the terminal, or nullptr if the deadline
+    // has passed. Anything else received is passed on as keyboard input.
     for (;;) {
-        const auto ch = os::getch();
-        // Ignore XON, XOFF
-        if (ch == '\021' || ch == '\023')
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+        if (remaining.count() <= 0) return nullptr;
+        auto ch = char{};
+        if (os::read_input(std::span{&ch, 1}, static_cast<int>(remaining.count())) == 0)
             continue;
-        // If we've sent an extra query, the last escape should be the
-        // start of that response, which we'll ultimately drop.
-        if (may_not_work && ch == '\033')
-            last_escape = response.length();
-        response += ch;
-        if (ch == final_char) break;
+        if (const auto report = parser.parse(ch))
+            return report;
     }
-    // Drop the extra response if one was requested.
-    if (may_not_work)
-        response = response.substr(0, last_escape);
-    auto match = std::smatch{};
-    std::regex_match(response, match, std::regex(pattern));
-    return match;
 }
@@ -4,28 +4,55 @@
 
 #pragma once
 
+#include "input.h"
+
+#include <chrono>
+#include <filesystem>
 #include <optional>
-#include <regex>
 #include <string>
-#include <string_view>
+#include <vector>
+
+class output;
+class parser;
+struct report;
 
 class capabilities {
 public:
-    capabilities();
-    std::optional<std::pair<int, int>> query_cursor_position() const;
-    std::optional<bool> query_mode(const int mode) const;
-    std::string query_setting(const std::string_view setting) const;
-    std::string query_color_table() const;
+    capabilities(output& output, input_queue& input);
+    static capabilities synthetic(output& output, input_queue& input);
+    bool wait_until_ready(const std::chrono::milliseconds allowance = {}) const;
 
     int width = 80;
     int height = 24;
     bool has_soft_fonts = false;
     bool has_color = false;
     bool has_8bit = false;
+    int conformance_level = 1;
     int terminal_id = 0;
 
+    std::optional<bool> original_decscnm;
+    std::optional<bool> original_decawm;
+    std::string original_decssdt;
+    std::string original_color_assignment;
+    std::string original_color_table;
+
 private:
-    void _query_device_attributes();
-    void _query_terminal_id();
-    static std::smatch _query(const char* pattern, const bool may_not_work);
+    using clock = std::chrono::steady_clock;
+
+    struct unprobed {};
+    capabilities(output& output, input_queue& input, unprobed);
+
+    bool _parse_report(const report& report);
+    void _parse_device_attributes(const report& report);
+    bool _receive_reports();
+    std::string _profile_key() const;
+    bool _load_profile(const std::string& key);
+    void _save_profile(const std::string& key) const;
+    static std::filesystem::path _profile_path(const std::string& key);
+    static const report* _read_report(parser& parser, const clock::time_point deadline);
+
+    output& _output;
+    input_queue& _input;
+    std::vector<int> _da1_params;
+    std::vector<int> _da2_params;
 };
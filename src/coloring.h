@@ -8,13 +8,15 @@
 
 class capabilities;
 class options;
+class output;
 
 class coloring {
 public:
-    coloring(const capabilities& caps, const options& options);
+    coloring(const capabilities& caps, const options& options, output& output);
     ~coloring();
 
 private:
+    output& _output;
     bool _using_colors;
     std::string _color_assignment;
     std::string _color_table;
@@ -4,22 +4,38 @@
 
 #pragma once
 
+#include "input.h"
+#include "parser.h"
+#include "playfield.h"
+
 class capabilities;
+class glyph_set;
 class options;
+class output;
+class pacer;
+class stats;
 
 class engine {
 public:
-    static constexpr int width = 60;
-    static constexpr int height = 24;
+    static constexpr int width = playfield::width;
+    static constexpr int height = playfield::height;
+
+    static glyph_set glyphs();
 
-    engine(const capabilities& caps, const options& options);
+    engine(const capabilities& caps, const options& options, output& output, input_source& source, input_queue& input, pacer& pacer, stats& stats);
     bool run();
 
 private:
+    void _read_input();
+
     const capabilities& _caps;
     const options& _options;
+    output& _output;
+    input_source& _source;
+    input_queue& _input;
+    pacer& _pacer;
+    stats& _stats;
 
-    volatile bool _fire_pressed = false;
-    volatile bool _right_pressed = false;
-    volatile bool _left_pressed = false;
+    parser _parser;
+    controls _controls;
 };
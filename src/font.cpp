@@ -5,11 +5,17 @@
 #include "font.h"
 
 #include "capabilities.h"
+#include "os.h"
+#include "output.h"
 
-#include <iostream>
-#include <string>
+#include <algorithm>
 
-constexpr auto font_8x10 = R"(0;1;1;4;0;0{ @
+// The glyph definitions for each cell size, in DECDLD sixel format. Each
+// size has been hand-tuned, so there is a separate set for every one. Line
+// breaks are only here for readability, and are dropped when the actual
+// payloads are generated at compile time.
+
+inline constexpr char sixels_8x10[] = R"(
 ???]]???/????????;
 ???FF???/????????;
 kk}}}}kk/DDAAAADD;
@@ -106,7 +112,7 @@ G??????A/????????;
 ????????/????????
 )";
 
-constexpr auto font_15x12 = R"(0;1;1;15;0;2;12;0{ @
+inline constexpr char sixels_15x12[] = R"(
 ??????}}}??????/???????????????;
 ??????FFF??????/???????????????;
 KKK}}}}}}KKKwww/JJJDDDDDDJJJDDD;
@@ -203,7 +209,7 @@ GGG?????????AAA/???????????????;
 ???????????????/???????????????
 )";
 
-constexpr auto font_10x20 = R"(0;1;1;10;0;2;20;0{ @
+inline constexpr char sixels_10x20[] = R"(
 ????{{????/????NN????/??????????/??????????;
 ????~~????/??????????/??????????/??????????;
 oo{{{{oo??/rr~~~~rr~~/rrKKKKrrKK/??????????;
@@ -300,7 +306,7 @@ oooo??????/~~~~~~????/~~KK??????/??????????;
 ??????????/??????????/??????????/??????????
 )";
 
-constexpr auto font_12x30 = R"(0;1;1;12;0;2;30;0{ @
+inline constexpr char sixels_12x30[] = R"(
 ????www?????/????~~~?????/????FFF?????/????????????/????????????;
 ????~~~?????/????FFF?????/????????????/????????????/????????????;
 ??wwwww?????/~~~~~~~~~www/ww~~~~~ww~~~/FFwwwwwFFwww/FF?????FF???;
@@ -397,7 +403,7 @@ wwwwwwwww???/~~~~~~~~~~~~/ww~~~~~wwwww/FFwwwwwFFFFF/?????????FFF;
 ????????????/????????????/????????????/????????????/????????????
 )";
 
-constexpr auto font_10x16 = R"(0;1;1;10;0;2;16;0{ @
+inline constexpr char sixels_10x16[] = R"(
 ????}}????/????BB????/??????????;
 ????NN????/??????????/??????????;
 ww}}}}wwoo/[[ffff[[ff/BB????BB??;
@@ -496,7 +502,106 @@ wwwwoo????/~~ffFF????/BB????????;
 
 namespace {
 
-    std::string get_font(const int terminal_id)
+    constexpr auto glyph_count = 94;
+    constexpr auto max_height = 36;
+
+    struct cell_size {
+        int width;
+        int height;
+    };
+
+    // Glyphs are stored as one bit per pixel, with a 32-bit mask per row.
+    using glyph = std::array<std::uint32_t, max_height>;
+    using glyph_bitmaps = std::array<glyph, glyph_count>;
+
+    constexpr glyph_bitmaps decode(const std::string_view sixels)
+    {
+        auto glyphs = glyph_bitmaps{};
+        auto index = 0;
+        auto y = 0;
+        auto x = 0;
+        for (const auto ch : sixels) {
+            if (ch == ';') {
+                index++;
+                y = x = 0;
+            } else if (ch == '/') {
+                y += 6;
+                x = 0;
+            } else if (ch >= '?' && ch <= '~') {
+                const auto sixel = ch - '?';
+                for (auto bit = 0; bit < 6; bit++)
+                    if (sixel & (1 << bit)) glyphs[index][y + bit] |= 1u << x;
+                x++;
+            }
+        }
+        return glyphs;
+    }
+
+    constexpr int encode(const glyph_bitmaps& glyphs, const cell_size cell, char* out)
+    {
+        // Blank sixels at the end of a row, and blank rows at the end of a
+        // glyph, are left out, since the cells are erased when the font is
+        // loaded. If out is null, we just return the length required.
+        auto length = 0;
+        const auto put = [&](const char ch) {
+            if (out) out[length] = ch;
+            length++;
+        };
+        // Anything outside the cell is clipped.
+        const auto sixel = [&](const glyph& glyph, const int y, const int x) {
+            auto value = 0;
+            for (auto bit = 0; bit < 6 && y + bit < cell.height; bit++)
+                if (glyph[y + bit] & (1u << x)) value |= 1 << bit;
+            return value;
+        };
+        for (auto i = 0; i < glyph_count; i++) {
+            if (i > 0) put(';');
+            const auto& glyph = glyphs[i];
+            auto rows = (cell.height + 5) / 6;
+            while (rows > 1 && !(glyph[rows * 6 - 6] | glyph[rows * 6 - 5] | glyph[rows * 6 - 4] | glyph[rows * 6 - 3] | glyph[rows * 6 - 2] | glyph[rows * 6 - 1]))
+                rows--;
+            for (auto row = 0; row < rows; row++) {
+                if (row > 0) put('/');
+                auto columns = cell.width;
+                while (columns > 1 && sixel(glyph, row * 6, columns - 1) == 0)
+                    columns--;
+                for (auto x = 0; x < columns; x++)
+                    put(static_cast<char>('?' + sixel(glyph, row * 6, x)));
+            }
+        }
+        return length;
+    }
+
+    // The DECDLD payload is generated at compile time from the glyph set
+    // for the cell size.
+    template <const auto& Sixels, cell_size Cell>
+    constexpr auto generate_font()
+    {
+        constexpr auto glyphs = decode(Sixels);
+        constexpr auto length = encode(glyphs, Cell, nullptr);
+        auto data = std::array<char, length>{};
+        encode(glyphs, Cell, data.data());
+        return data;
+    }
+
+    struct font {
+        std::string_view matrix;
+        std::string_view data;
+    };
+
+    constexpr auto data_8x10 = generate_font<sixels_8x10, cell_size{8, 10}>();
+    constexpr auto data_15x12 = generate_font<sixels_15x12, cell_size{15, 12}>();
+    constexpr auto data_10x20 = generate_font<sixels_10x20, cell_size{10, 20}>();
+    constexpr auto data_12x30 = generate_font<sixels_12x30, cell_size{12, 30}>();
+    constexpr auto data_10x16 = generate_font<sixels_10x16, cell_size{10, 16}>();
+
+    constexpr auto font_8x10 = font{"4;0;0", {data_8x10.data(), data_8x10.size()}};
+    constexpr auto font_15x12 = font{"15;0;2;12;0", {data_15x12.data(), data_15x12.size()}};
+    constexpr auto font_10x20 = font{"10;0;2;20;0", {data_10x20.data(), data_10x20.size()}};
+    constexpr auto font_12x30 = font{"12;0;2;30;0", {data_12x30.data(), data_12x30.size()}};
+    constexpr auto font_10x16 = font{"10;0;2;16;0", {data_10x16.data(), data_10x16.size()}};
+
+    font get_font(const int terminal_id)
     {
         switch (terminal_id) {
             case 1:  // VT220 - 8x10
@@ -524,28 +629,99 @@ namespace {
 
 }  // namespace
 
-soft_font::soft_font(const capabilities& caps)
+soft_font::soft_font(const capabilities& caps, output& output, const glyph_set& glyphs)
+    : _output{output}
 {
-    auto font_data = get_font(caps.terminal_id);
-    if (caps.has_soft_fonts && !font_data.empty()) {
-        // Some terminals (like RLogin) will not cope with DECDLD content
-        // containing newlines, so we need to strip those out first.
-        for (auto i = 0; i < font_data.size(); i++)
-            if (font_data[i] == '\n')
-                font_data.erase(i--, 1);
-        std::cout << "\033P" << font_data << "\033\\";
-        // VTStar seems to get itself stuck when downloading a soft font, but
-        // that can be fixed by flooding it with a bunch of SGR sequences.
-        for (auto i = 0; i < 100; i++)
-            std::cout << "\033[0;1m";
-        std::cout << "\033[m";
-        // We enable the new font by default.
-        std::cout << "\033( @";
+    if (!caps.has_soft_fonts) return;
+
+    const auto font = get_font(caps.terminal_id);
+    auto definitions = std::array<std::string_view, glyph_count>{};
+    auto remaining = font.data;
+    for (auto& definition : definitions) {
+        const auto end = std::min(remaining.find(';'), remaining.size());
+        definition = remaining.substr(0, end);
+        remaining.remove_prefix(std::min(end + 1, remaining.size()));
+    }
+
+    // Only the glyphs that are actually used are downloaded. The unused
+    // glyphs between two used ones are sent as empty definitions, which
+    // cost a byte each, unless the gap is long enough that it's cheaper to
+    // start a new DECDLD sequence.
+    constexpr auto max_header_size = std::string_view{"\033P0;94;1;{ @\033\\"}.size();
+    const auto gap_limit = static_cast<int>(max_header_size + font.matrix.size());
+    const auto start_time = std::chrono::steady_clock::now();
+    auto bytes = 0;
+    const auto send = [&](const auto& value) {
+        const auto start_size = _output.size();
+        _output << value;
+        bytes += static_cast<int>(_output.size() - start_size);
+    };
+    for (auto i = 0; i < glyph_count;) {
+        if (!glyphs.contains('!' + i)) {
+            i++;
+            continue;
+        }
+        auto end = i + 1;
+        for (auto gap = 0; end + gap < glyph_count && gap < gap_limit;) {
+            if (glyphs.contains('!' + end + gap)) {
+                end += gap + 1;
+                gap = 0;
+            } else {
+                gap++;
+            }
+        }
+        send("\033P0;");
+        send(i + 1);
+        send(";1;");
+        send(font.matrix);
+        send("{ @");
+        for (auto n = i; n < end; n++) {
+            if (n > i) send(';');
+            if (glyphs.contains('!' + n)) {
+                send(definitions[n]);
+                _glyph_count++;
+            }
+        }
+        send("\033\\");
+        _run_count++;
+        i = end;
     }
+
+    // Rather than assume how long the download will take, we wait for the
+    // terminal to confirm it has processed it. VTStar seems to get itself
+    // stuck when downloading a soft font, and this gives it the nudge that
+    // used to come from flooding it with SGR sequences.
+    _bytes = bytes;
+    _baud_rate = os::baud_rate();
+    const auto estimate = _estimated_time();
+    caps.wait_until_ready(std::chrono::ceil<std::chrono::milliseconds>(estimate));
+    _load_time = std::chrono::steady_clock::now() - start_time;
+
+    // We enable the new font by default.
+    _output << "\033( @";
 }
 
 soft_font::~soft_font()
 {
     // Make sure the ASCII character set is restored on exit.
-    std::cout << "\033(B";
+    _output << "\033(B";
+}
+
+void soft_font::report(output& out) const
+{
+    const auto milliseconds = [](const auto duration) {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    };
+    out << "Soft font: " << _glyph_count << " glyphs in " << _run_count << " DECDLD runs, ";
+    out << _bytes << " bytes, loaded in (ms) " << milliseconds(_load_time);
+    if (_baud_rate > 0)
+        out << ", estimated (ms) " << milliseconds(_estimated_time()) << " at " << _baud_rate << " baud";
+    out << '\n';
+}
+
+std::chrono::steady_clock::duration soft_font::_estimated_time() const
+{
+    // Assuming 10 bits per byte (8N1 framing).
+    if (_baud_rate <= 0) return {};
+    return std::chrono::microseconds{std::int64_t{_bytes} * 10 * 1000000 / _baud_rate};
 }
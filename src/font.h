@@ -4,10 +4,58 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
 class capabilities;
+class output;
+
+// The set of soft font glyphs that some text depends on.
+class glyph_set {
+public:
+    constexpr void add(const std::string_view text)
+    {
+        for (const auto ch : text)
+            if (ch > ' ' && ch < '\177') _bits[(ch - '!') / 64] |= std::uint64_t{1} << ((ch - '!') % 64);
+    }
+
+    template <typename T, std::size_t N>
+    constexpr void add(const std::array<T, N>& texts)
+    {
+        for (const auto& text : texts) add(text);
+    }
+
+    constexpr bool contains(const char ch) const
+    {
+        return ch > ' ' && ch < '\177' && (_bits[(ch - '!') / 64] & (std::uint64_t{1} << ((ch - '!') % 64)));
+    }
+
+    constexpr glyph_set& operator|=(const glyph_set& other)
+    {
+        _bits[0] |= other._bits[0];
+        _bits[1] |= other._bits[1];
+        return *this;
+    }
+
+private:
+    std::array<std::uint64_t, 2> _bits = {};
+};
 
 class soft_font {
 public:
-    soft_font(const capabilities& caps);
+    soft_font(const capabilities& caps, output& output, const glyph_set& glyphs);
     ~soft_font();
+    void report(output& out) const;
+
+private:
+    std::chrono::steady_clock::duration _estimated_time() const;
+
+    output& _output;
+    int _glyph_count = 0;
+    int _run_count = 0;
+    int _bytes = 0;
+    int _baud_rate = 0;
+    std::chrono::steady_clock::duration _load_time = {};
 };
@@ -0,0 +1,117 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "input.h"
+
+#include "os.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+    // Measured in frames rather than time, so the outcome doesn't depend on
+    // how fast the game is running. At the default speed, this is 100ms.
+    constexpr auto max_move_age = 5;
+
+}  // namespace
+
+int terminal_input::read(std::span<char> buffer)
+{
+    return os::read_input(buffer);
+}
+
+scripted_input::scripted_input(const int frames)
+    : _frames_remaining{frames}
+{
+}
+
+int scripted_input::read(std::span<char> buffer)
+{
+    // Every other call returns nothing, which marks the end of the frame.
+    if (std::exchange(_frame_read, !_frame_read)) return 0;
+    if (_frames_remaining-- <= 0) {
+        buffer[0] = 'q';
+        return 1;
+    }
+    // A simple LCG keeps the sequence the same on every run. The turret
+    // sweeps in one direction for a while before turning around, and fires
+    // whenever it can.
+    _seed = _seed * 1103515245 + 12345;
+    const auto random = (_seed >> 16) & 0x7FFF;
+    auto count = 0;
+    if (random % 64 == 0) _moving_right = !_moving_right;
+    if (random % 2 == 0) {
+        for (const auto ch : _moving_right ? "\033[C" : "\033[D")
+            if (ch) buffer[count++] = ch;
+    }
+    if (random % 8 == 0) buffer[count++] = ' ';
+    // With nothing to send, this call has already ended the frame.
+    if (count == 0) _frame_read = false;
+    return count;
+}
+
+void controls::reset(input_queue& queue)
+{
+    // Any key presses from the previous level are discarded, other than a
+    // request to quit.
+    auto event = input_event{};
+    while (queue.pop(event)) {
+        if (event.key == key::quit) _quit = true;
+    }
+    _move_count = 0;
+    _fire.reset();
+}
+
+void controls::update(input_queue& queue)
+{
+    // Movement presses that haven't been acted on for a while are dropped,
+    // so they don't suddenly take effect long after the turret was able to
+    // move (e.g. after an explosion).
+    _frame++;
+    const auto first_live = std::find_if(_moves.begin(), _moves.begin() + _move_count, [&](const auto& move) {
+        return _frame - move.frame < max_move_age;
+    });
+    if (first_live != _moves.begin()) {
+        const auto live_end = std::move(first_live, _moves.begin() + _move_count, _moves.begin());
+        _move_count = static_cast<int>(live_end - _moves.begin());
+    }
+
+    // Every press is queued, so two presses in the same frame still result
+    // in two steps, one per frame. A press in the opposite direction to the
+    // last pending move cancels it out, though. A fire press is held until
+    // the turret is able to act on it, and is dropped if the laser is still
+    // in flight at that point.
+    auto event = input_event{};
+    while (queue.pop(event)) {
+        if (event.key == key::quit) {
+            _quit = true;
+        } else if (event.key == key::fire) {
+            if (!_fire) _fire = event;
+        } else if (_move_count > 0 && _moves[_move_count - 1].event.key != event.key) {
+            _move_count--;
+        } else if (_move_count < max_moves) {
+            _moves[_move_count++] = {event, _frame};
+        }
+    }
+}
+
+std::optional<input_event> controls::take_move()
+{
+    if (_move_count == 0) return {};
+    const auto move = _moves[0];
+    std::move(_moves.begin() + 1, _moves.begin() + _move_count, _moves.begin());
+    _move_count--;
+    return move.event;
+}
+
+std::optional<input_event> controls::take_fire()
+{
+    return std::exchange(_fire, std::nullopt);
+}
+
+bool controls::quit_requested() const
+{
+    return _quit;
+}
@@ -0,0 +1,78 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include "queue.h"
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <span>
+
+enum class key {
+    fire,
+    left,
+    right,
+    quit
+};
+
+struct input_event {
+    using clock = std::chrono::steady_clock;
+
+    ::key key = ::key::fire;
+    clock::time_point time = {};
+};
+
+using input_queue = spsc_queue<input_event, 64>;
+
+// The source of the raw input characters read by the engine. Each frame, the
+// engine reads until no more characters are available.
+class input_source {
+public:
+    virtual ~input_source() = default;
+    virtual int read(std::span<char> buffer) = 0;
+};
+
+class terminal_input : public input_source {
+public:
+    int read(std::span<char> buffer) override;
+};
+
+// Generates a fixed pseudo-random sequence of key presses, one batch per
+// frame, followed by a quit request after the given number of frames.
+class scripted_input : public input_source {
+public:
+    scripted_input(const int frames);
+    int read(std::span<char> buffer) override;
+
+private:
+    int _frames_remaining;
+    bool _frame_read = false;
+    unsigned _seed = 1;
+    bool _moving_right = true;
+};
+
+class controls {
+public:
+    void reset(input_queue& queue);
+    void update(input_queue& queue);
+    std::optional<input_event> take_move();
+    std::optional<input_event> take_fire();
+    bool quit_requested() const;
+
+private:
+    static constexpr int max_moves = 4;
+
+    struct pending_move {
+        input_event event;
+        int frame = 0;
+    };
+
+    std::array<pending_move, max_moves> _moves = {};
+    int _move_count = 0;
+    int _frame = 0;
+    std::optional<input_event> _fire;
+    bool _quit = false;
+};
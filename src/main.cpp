@@ -2,108 +2,166 @@
 // Copyright (c) 2024 James Holderness
 // Distributed under the MIT License
 
+#include "allocations.h"
+#include "bench.h"
 #include "capabilities.h"
 #include "coloring.h"
 #include "engine.h"
 #include "font.h"
 #include "options.h"
 #include "os.h"
+#include "output.h"
+#include "pacer.h"
+#include "stats.h"
+#include "trace.h"
 
-#include <iostream>
+#include <fstream>
 #include <thread>
 
 using namespace std::chrono_literals;
 
-bool check_compatibility(const capabilities& caps, const options& options)
+constexpr auto title = "VT INVADERS";
+
+bool check_compatibility(const capabilities& caps, const options& options, output& out)
 {
     if (!caps.has_soft_fonts && !options.yolo) {
-        std::cout << "VT Invaders requires a VT320-compatible terminal or better.\n";
-        std::cout << "Try 'vtinvaders --yolo' to bypass the compatibility checks.\n";
+        out << "VT Invaders requires a VT320-compatible terminal or better.\n";
+        out << "Try 'vtinvaders --yolo' to bypass the compatibility checks.\n";
         return false;
     }
     if (caps.height < engine::height) {
-        std::cout << "VT Invaders requires a minimum screen height of " << engine::height << ".\n";
+        out << "VT Invaders requires a minimum screen height of " << engine::height << ".\n";
         return false;
     }
     if (caps.width < engine::width) {
-        std::cout << "VT Invaders requires a minimum screen width of " << engine::width << ".\n";
+        out << "VT Invaders requires a minimum screen width of " << engine::width << ".\n";
         return false;
     }
     return true;
 }
 
-void title_banner(const capabilities& caps)
+void title_banner(const capabilities& caps, output& out)
 {
     const auto y = (caps.height + 1) / 2;
     const auto x = (caps.width - 11 * 2 + 2) / 4 + 1;
-    std::cout << "\033[" << y << ';' << x << "H";
-    std::cout << "\033#6";
-    std::cout << "VT INVADERS";
-    std::cout.flush();
+    out << "\033[" << y << ';' << x << "H";
+    out << "\033#6";
+    out << title;
+    out.flush();
     std::this_thread::sleep_for(3s);
     // MLTerm doesn't reset double-width lines correctly, so we need to
     // manually reset the title banner line before starting the game.
-    std::cout << "\033[2K\033#5";
+    out << "\033[2K\033#5";
 }
 
 int main(const int argc, const char* argv[])
 {
+    auto trace = startup_trace{};
+
     os os;
+    trace.end_phase("os");
 
     options options(argc, argv);
     if (options.exit)
         return 1;
+    if (options.bench)
+        return run_benchmark(options);
+    trace.end_phase("options");
 
-    capabilities caps;
-    if (!check_compatibility(caps, options))
+    // Output is written to the terminal from a separate thread, so a slow
+    // connection doesn't hold up the game loop.
+    auto stdout_sink = fd_sink{1};
+    auto writer = async_sink{stdout_sink};
+    auto out = output{writer};
+
+    // Key presses are queued from the moment we start reading input, since
+    // they may be mixed in with the responses to our capability queries.
+    auto input = input_queue{};
+    capabilities caps{out, input};
+    if (!check_compatibility(caps, options, out))
         return 1;
+    trace.end_phase("capabilities", out.total_size());
 
     // Set the window title.
-    std::cout << "\033]21;VT Invaders\033\\";
+    out << "\033]21;VT Invaders\033\\";
     // Set default attributes.
-    std::cout << "\033[m";
+    out << "\033[m";
     // Clear the screen.
-    std::cout << "\033[2J";
-    // Save the modes and settings that we're going to change.
-    const auto original_decscnm = caps.query_mode(5);
-    const auto original_decawm = caps.query_mode(7);
-    const auto original_decssdt = caps.query_setting("$~");
+    out << "\033[2J";
     // Hide the cursor.
-    std::cout << "\033[?25l";
+    out << "\033[?25l";
     // Disable line wrapping.
-    std::cout << "\033[?7l";
+    out << "\033[?7l";
     // Hide the status line.
-    std::cout << "\033[0$~";
-    // Load the soft font.
-    const auto font = soft_font{caps};
+    out << "\033[0$~";
+    trace.end_phase("screen setup", out.total_size());
+    // Load the soft font, with just the glyphs that we need.
+    auto glyphs = engine::glyphs();
+    glyphs.add(title);
+    const auto font = soft_font{caps, out, glyphs};
+    trace.end_phase("soft_font", out.total_size());
     // Setup the color assignment and palette.
-    const auto colors = coloring{caps, options};
+    const auto colors = coloring{caps, options, out};
+    trace.end_phase("coloring", out.total_size());
     // Wait until the terminal is ready.
-    caps.query_cursor_position();
+    caps.wait_until_ready();
+    trace.end_phase("ready", out.total_size());
 
-    title_banner(caps);
+    title_banner(caps, out);
+    trace.end_phase("title_banner", out.total_size());
+    auto source = terminal_input{};
+    auto frame_pacer = pacer{options.fps};
+    auto game_stats = stats{options.fps};
     while (true) {
-        auto game_engine = engine{caps, options};
+        auto game_engine = engine{caps, options, out, source, input, frame_pacer, game_stats};
         if (!game_engine.run()) break;
     }
 
     // Clear the window title.
-    std::cout << "\033]21;\033\\";
+    out << "\033]21;\033\\";
     // Set default attributes.
-    std::cout << "\033[m";
+    out << "\033[m";
     // Clear the screen.
-    std::cout << "\033[H\033[J";
+    out << "\033[H\033[J";
     // Reset reverse screen attributes if not originally set.
-    if (original_decscnm != true)
-        std::cout << "\033[?5l";
+    if (caps.original_decscnm != true)
+        out << "\033[?5l";
     // Reapply line wrapping if not originally reset.
-    if (original_decawm != false)
-        std::cout << "\033[?7h";
+    if (caps.original_decawm != false)
+        out << "\033[?7h";
     // Restore the original status display type.
-    if (!original_decssdt.empty())
-        std::cout << "\033[" << original_decssdt;
+    if (!caps.original_decssdt.empty())
+        out << "\033[" << caps.original_decssdt;
     // Show the cursor.
-    std::cout << "\033[?25h";
+    out << "\033[?25h";
+    // Switch back to the ASCII character set for the reports below.
+    out << "\033(B";
+    // Report any heap allocations made in the game loop.
+    allocations::report(out);
+    // Report the startup timeline if requested.
+    if (options.startup_trace)
+        trace.report(out);
+    // Report the performance statistics if requested, either on the screen
+    // or saved to a file.
+    const auto report_stats = [&](output& out) {
+        font.report(out);
+        frame_pacer.report(out);
+        game_stats.report(out);
+        out << "Output: max writer lag (us) ";
+        out << static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(writer.max_writer_lag()).count()) << '\n';
+    };
+    if (options.stats)
+        report_stats(out);
+    if (!options.stats_file.empty()) {
+        auto report = memory_sink{};
+        auto report_out = output{report};
+        report_stats(report_out);
+        report_out.flush();
+        auto file = std::ofstream{options.stats_file, std::ios::binary};
+        file << report.data();
+        if (!file)
+            out << "Unable to save the statistics to '" << options.stats_file << "'\n";
+    }
 
     return 0;
 }
@@ -0,0 +1,218 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "aliens.h"
+#include "capabilities.h"
+#include "engine.h"
+#include "input.h"
+#include "missiles.h"
+#include "options.h"
+#include "output.h"
+#include "parser.h"
+#include "playfield.h"
+#include "screen.h"
+#include "shields.h"
+#include "simulation.h"
+#include "turret.h"
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+// Microbenchmarks for the rendering and simulation hot paths. Everything is
+// output to an in-memory sink, so the results only reflect the cost of the
+// code itself, and the bytes it would have sent to the terminal.
+
+namespace {
+
+    using clock = std::chrono::steady_clock;
+
+    // Each benchmark is repeated in batches until it has run for at least
+    // this long, so the timer resolution doesn't matter.
+    constexpr auto min_duration = std::chrono::milliseconds{200};
+    constexpr auto batch_size = 1000;
+
+    // A typical set of responses to the startup queries.
+    constexpr auto capability_reports = std::string_view{
+        "\033[24;80R"
+        "\033[>65;20;1c"
+        "\033[?65;1;2;6;7;8;9;15;18;21;22;28;29c"
+        "\033[0n"
+        "\033[?5;2$y"
+        "\033[?7;1$y"
+        "\033P1$r0$~\033\\"
+        "\033P1$r1;1,|\033\\"
+        "\033P2$s1;2;0;0;0/2;2;0;0;49/3;2;120;46;71/4;2;240;50;50\033\\"
+        "\033[?65;1;2;6;7;8;9;15;18;21;22;28;29c"};
+
+    // A simple LCG, so the positions are the same on every run.
+    class sequence {
+    public:
+        int next(const int range)
+        {
+            _seed = _seed * 1103515245 + 12345;
+            return static_cast<int>((_seed >> 16) & 0x7FFF) % range;
+        }
+
+    private:
+        unsigned _seed = 1;
+    };
+
+    // The byte count is taken from a function, so each benchmark can decide
+    // what is worth counting.
+    template <typename Bytes, typename F>
+    void measure(output& report, const char* name, Bytes&& bytes_counted, F&& operation)
+    {
+        const auto start_bytes = bytes_counted();
+        const auto start_time = clock::now();
+        auto elapsed = clock::duration{};
+        auto count = 0LL;
+        while (elapsed < min_duration) {
+            for (auto i = 0; i < batch_size; i++)
+                operation();
+            count += batch_size;
+            elapsed = clock::now() - start_time;
+        }
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        const auto bytes = static_cast<long long>(bytes_counted() - start_bytes);
+        const auto hundredths = static_cast<int>(bytes * 100 / count);
+        report << name << ": " << static_cast<int>(nanoseconds / count) << " ns/op, ";
+        report << hundredths / 100 << '.' << (hundredths % 100 < 10 ? "0" : "") << hundredths % 100;
+        report << " bytes/op\n";
+    }
+
+}  // namespace
+
+int main(const int argc, const char* argv[])
+{
+    auto stdout_sink = fd_sink{1};
+    auto report = output{stdout_sink};
+
+    // The game objects render to a screen with the same synthetic profile
+    // as the --bench mode, and never pause.
+    auto options = ::options{argc, argv};
+    if (options.exit) return 1;
+    options.bench = true;
+    auto game_sink = null_sink{};
+    auto out = output{game_sink};
+    auto input = input_queue{};
+    const auto caps = capabilities::synthetic(out, input);
+    auto field = playfield{};
+    auto screen = ::screen{caps, options, out, field};
+    field.reset();
+    auto positions = sequence{};
+    const auto output_size = [&] { return out.total_size(); };
+
+    measure(report, "output::write (CUP sequence)", output_size, [&] {
+        out << "\033[" << positions.next(24) + 1 << ';' << positions.next(80) + 1 << 'H';
+        if (out.size() >= output::chunk_size) out.flush();
+    });
+
+    // The screen cases include the playfield write, and the flush that then
+    // outputs it, cursor movement included.
+    measure(report, "screen::flush (one cell anywhere)", output_size, [&] {
+        const auto y = positions.next(engine::height) + 1;
+        const auto x = positions.next(engine::width) + 1;
+        field.write(y, x, field.at(y, x) == playfield::empty ? '#' : ' ', color::any, 0);
+        screen.flush();
+    });
+
+    auto phase = false;
+    measure(report, "screen::flush (3 char string)", output_size, [&] {
+        const auto y = positions.next(engine::height) + 1;
+        const auto x = positions.next(engine::width - 2) + 1;
+        field.write(y, x, (phase = !phase) ? "abc" : "xyz", color::white);
+        screen.flush();
+    });
+
+    field.reset();
+    auto turret = ::turret{field};
+    auto aliens = ::aliens{field};
+    const auto reset_aliens = [&] {
+        aliens.reset();
+        for (auto frame = 0; !aliens.init(frame, 0); frame++) {
+        }
+        screen.flush();
+    };
+    reset_aliens();
+    measure(report, "aliens::update", output_size, [&] {
+        aliens.update(turret);
+        screen.flush();
+        if (aliens.landed()) reset_aliens();
+    });
+
+    reset_aliens();
+    measure(report, "aliens::fire", output_size, [&] {
+        if (aliens.can_fire()) aliens.fire();
+    });
+
+    auto missiles = ::missiles{field};
+    auto missile_frame = 0;
+    measure(report, "missiles::update", output_size, [&] {
+        if (missile_frame % 3 == 0 && missiles.can_fire())
+            missiles.fire(positions.next(8) + 2, positions.next(engine::width - 2) + 2);
+        missiles.update(missile_frame++, [](const auto, const auto) {});
+        screen.flush();
+    });
+
+    field.reset();
+    auto shields = ::shields{field};
+    auto shield_hits = 0;
+    measure(report, "shields::hit", output_size, [&] {
+        if (shield_hits++ % 64 == 0) shields.reset();
+        shields.hit(positions.next(2) == 0, positions.next(engine::width) + 1);
+        screen.flush();
+    });
+
+    measure(report, "shields::update", output_size, [&] {
+        shields.update();
+        screen.flush();
+    });
+
+    field.reset();
+    auto laser = ::laser{field};
+    measure(report, "laser::update", output_size, [&] {
+        laser.fire(positions.next(engine::width - 2) + 2);
+        laser.update();
+        screen.flush();
+    });
+
+    // The complete game, without any rendering, and with no input, so it
+    // plays itself until the aliens land.
+    auto controls = ::controls{};
+    auto game = std::optional<simulation>{};
+    const auto start_game = [&] {
+        game.emplace();
+        game->start_level();
+    };
+    start_game();
+    measure(report, "simulation::step (headless)", [] { return 0; }, [&] {
+        const auto outcome = game->step(controls);
+        if (outcome == simulation::outcome::level_cleared) game->start_level();
+        if (outcome == simulation::outcome::game_over) start_game();
+        game->field().clear_changes();
+    });
+
+    // The bytes counted are those copied by the snapshot in each direction.
+    auto snapshot = game->save();
+    auto snapshot_bytes = std::size_t{0};
+    measure(report, "simulation::save + restore", [&] { return snapshot_bytes; }, [&] {
+        game->restore(snapshot);
+        snapshot = game->save();
+        snapshot_bytes += sizeof(snapshot) * 2;
+    });
+
+    // For the parser, the bytes are those parsed rather than output.
+    auto reports = parser{input};
+    auto parsed = std::size_t{0};
+    measure(report, "parser::parse (startup reports)", [&] { return parsed; }, [&] {
+        for (const auto ch : capability_reports)
+            reports.parse(ch);
+        parsed += capability_reports.size();
+    });
+
+    report.flush();
+    return 0;
+}
@@ -5,7 +5,8 @@
 #include "missiles.h"
 
 #include "engine.h"
-#include "screen.h"
+#include "font.h"
+#include "playfield.h"
 
 namespace {
 
@@ -15,47 +16,56 @@ namespace {
 
 }  // namespace
 
-missiles::missiles(screen& screen)
-    : _screen{screen}
+glyph_set missiles::glyphs()
+{
+    auto glyphs = glyph_set{};
+    glyphs.add(missile_sprites);
+    glyphs.add(explosion_sprites);
+    glyphs.add(ground_sprites);
+    return glyphs;
+}
+
+missiles::missiles(playfield& playfield)
+    : _playfield{playfield}
 {
 }
 
 void missiles::reset()
 {
-    _active_count = 0;
-    _fire_frame = 174;
-    _can_fire = false;
-    for (auto& missile : _missiles)
+    _state.active_count = 0;
+    _state.fire_frame = 174;
+    _state.can_fire = false;
+    for (auto& missile : _state.missiles)
         missile.reset();
 }
 
 void missiles::update(const int frame, const hit_function& on_hit)
 {
-    for (auto& missile : _missiles) {
-        if (missile.update(on_hit, _screen))
-            if (--_active_count == 0)
-                _fire_frame = frame + 12;
+    for (auto& missile : _state.missiles) {
+        if (missile.update(on_hit, _playfield))
+            if (--_state.active_count == 0)
+                _state.fire_frame = frame + 12;
     }
     // For the first 2000 frames, only 1 missile may be fired at a time, and
     // thereafter we can have up to 3 simultaneously. A new missile may be
     // fired 12 frames after the last one terminated (see above), or 50 frames
     // after the last one was launched (see the fire method below).
     const auto max_active = (frame < 2000 ? 1 : 3);
-    _can_fire = (frame >= _fire_frame && _active_count < max_active);
-    _fire_frame = std::max(_fire_frame, frame);
+    _state.can_fire = (frame >= _state.fire_frame && _state.active_count < max_active);
+    _state.fire_frame = std::max(_state.fire_frame, frame);
 }
 
 bool missiles::can_fire() const
 {
-    return _can_fire;
+    return _state.can_fire;
 }
 
 void missiles::fire(const int y, const int x)
 {
-    for (auto& missile : _missiles)
-        if (missile.fire(y, x, _screen)) {
-            _active_count++;
-            _fire_frame += 50;
+    for (auto& missile : _state.missiles)
+        if (missile.fire(y, x, _playfield)) {
+            _state.active_count++;
+            _state.fire_frame += 50;
             break;
         }
 }
@@ -65,24 +75,24 @@ void missiles::instance::reset()
     _active = false;
 }
 
-bool missiles::instance::update(const hit_function& on_hit, screen& screen)
+bool missiles::instance::update(const hit_function& on_hit, playfield& playfield)
 {
     if (!_active) return false;
 
     if (_y == engine::height - 2) {
         if (_phase == 1)
-            _render(explosion_sprites[0], screen);
+            _render(explosion_sprites[0], playfield);
         else if (_phase == 2)
-            _render(explosion_sprites[1], screen);
+            _render(explosion_sprites[1], playfield);
         else if (_phase == 5)
-            _render(ground_sprites[_x % 2], screen);
+            _render(ground_sprites[_x % 2], playfield);
         _active = (++_phase < 6);
         return !_active;
     }
 
-    const auto hit_id = screen.at(_y + 1, _x);
-    if (hit_id != screen::empty && hit_id != missiles::id) {
-        screen.write(_y, _x, ' ');
+    const auto hit_id = playfield.at(_y + 1, _x);
+    if (hit_id != playfield::empty && hit_id != missiles::id) {
+        playfield.write(_y, _x, ' ');
         on_hit(hit_id, _x);
         _active = false;
         return true;
@@ -90,16 +100,16 @@ bool missiles::instance::update(const hit_function& on_hit, screen& screen)
 
     _phase ^= 1;
     if (_phase == 0)
-        _render(missile_sprites[0], screen);
+        _render(missile_sprites[0], playfield);
     else if (_y % 2 == 0)
-        _render(missile_sprites[1], screen);
+        _render(missile_sprites[1], playfield);
     else
-        _render(missile_sprites[2], screen);
+        _render(missile_sprites[2], playfield);
     _y += _phase;
     return false;
 }
 
-bool missiles::instance::fire(const int y, const int x, screen& screen)
+bool missiles::instance::fire(const int y, const int x, playfield& playfield)
 {
     if (_active) return false;
     _y = y;
@@ -109,9 +119,19 @@ bool missiles::instance::fire(const int y, const int x, screen& screen)
     return true;
 }
 
-void missiles::instance::_render(const char* sprite, screen& screen)
+void missiles::instance::_render(const char* sprite, playfield& playfield)
+{
+    if (playfield.at(_y, _x) == missiles::id)
+        playfield.write(_y, _x, sprite[0], playfield::color_for_row(_y), missiles::id);
+    playfield.write(_y + 1, _x, sprite[1], playfield::color_for_row(_y + 1), missiles::id);
+}
+
+missiles::state missiles::save() const
+{
+    return _state;
+}
+
+void missiles::restore(const state& state)
 {
-    if (screen.at(_y, _x) == missiles::id)
-        screen.write(_y, _x, sprite[0], screen::color_for_row(_y), missiles::id);
-    screen.write(_y + 1, _x, sprite[1], screen::color_for_row(_y + 1), missiles::id);
+    _state = state;
 }
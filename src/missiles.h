@@ -5,16 +5,42 @@
 #pragma once
 
 #include <array>
-#include <functional>
+#include <type_traits>
 
-class screen;
+class glyph_set;
+class playfield;
 
 class missiles {
 public:
     static constexpr int id = 'M';
-    using hit_function = std::function<void(int, int)>;
 
-    missiles(screen& screen);
+    // A non-owning reference to the hit callback, so we don't need to
+    // allocate anything when passing a lambda through to the instances.
+    class hit_function {
+    public:
+        template <typename F>
+            requires(!std::is_same_v<std::remove_cvref_t<F>, hit_function>)
+        hit_function(F&& function)
+            : _function{&function}
+        {
+            _invoke = [](void* function, const int hit_id, const int x) {
+                (*static_cast<std::remove_reference_t<F>*>(function))(hit_id, x);
+            };
+        }
+
+        void operator()(const int hit_id, const int x) const
+        {
+            _invoke(_function, hit_id, x);
+        }
+
+    private:
+        void* _function;
+        void (*_invoke)(void*, const int, const int);
+    };
+
+    static glyph_set glyphs();
+
+    missiles(playfield& playfield);
     void reset();
     void update(const int frame, const hit_function& on_hit);
     bool can_fire() const;
@@ -24,11 +50,11 @@ private:
     class instance {
     public:
         void reset();
-        bool update(const hit_function& on_hit, screen& screen);
-        bool fire(const int y, const int x, screen& screen);
+        bool update(const hit_function& on_hit, playfield& playfield);
+        bool fire(const int y, const int x, playfield& playfield);
 
     private:
-        void _render(const char* sprite, screen& screen);
+        void _render(const char* sprite, playfield& playfield);
 
         int _y = 0;
         int _x = 0;
@@ -36,9 +62,18 @@ private:
         bool _active = false;
     };
 
-    screen& _screen;
-    std::array<instance, 3> _missiles = {};
-    int _active_count = 0;
-    int _fire_frame = 0;
-    bool _can_fire = false;
+public:
+    struct state {
+        std::array<instance, 3> missiles = {};
+        int active_count = 0;
+        int fire_frame = 0;
+        bool can_fire = false;
+    };
+
+    state save() const;
+    void restore(const state& state);
+
+private:
+    playfield& _playfield;
+    state _state;
 };
@@ -5,6 +5,8 @@
 #include "options.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -17,6 +19,16 @@ options::options(const int argc, const char* argv[])
             color = false;
         } else if (arg == "--yolo") {
             yolo = true;
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--stats-file" && i + 1 < argc) {
+            stats_file = argv[++i];
+        } else if (arg == "--startup-trace") {
+            startup_trace = true;
+        } else if (arg == "--bench") {
+            bench = true;
+            if (i + 1 < argc && std::isdigit(argv[i + 1][0]))
+                bench_frames = std::max(std::atoi(argv[++i]), 1);
         } else if (arg == "--speed" && i + 1 < argc) {
             try {
                 fps = std::stoi(argv[++i]) * 10;
@@ -29,6 +41,12 @@ options::options(const int argc, const char* argv[])
             std::cout << "  --mono        no coloring\n";
             std::cout << "  --speed N     set initial speed (1 to 10)\n";
             std::cout << "  --yolo        bypass compatibility checks\n";
+            std::cout << "  --stats       display performance statistics on exit\n";
+            std::cout << "  --stats-file FILE\n";
+            std::cout << "                save performance statistics to FILE on exit\n";
+            std::cout << "  --startup-trace\n";
+            std::cout << "                display the startup timeline on exit\n";
+            std::cout << "  --bench [N]   run a headless benchmark of N frames and exit\n";
             std::cout << "  --help        display this help and exit\n";
             exit = true;
         } else {
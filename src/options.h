@@ -4,12 +4,19 @@
 
 #pragma once
 
+#include <string>
+
 class options {
 public:
     options(const int argc, const char* argv[]);
 
     bool color = true;
     bool yolo = false;
+    bool stats = false;
+    std::string stats_file;
+    bool startup_trace = false;
+    bool bench = false;
+    int bench_frames = 10000;
     bool exit = false;
     int fps = 50;
 };
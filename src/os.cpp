@@ -4,10 +4,25 @@
 
 #include "os.h"
 
+namespace {
+
+    std::size_t total_bytes_read = 0;
+
+}  // namespace
+
+std::size_t os::bytes_read()
+{
+    return total_bytes_read;
+}
+
 #ifdef _WIN32
 
 #include <Windows.h>
 
+#include <algorithm>
+#include <array>
+#include <iterator>
+
 DWORD output_mode;
 DWORD input_mode;
 
@@ -32,24 +47,70 @@ os::~os()
     SetConsoleMode(input_handle, input_mode);
 }
 
-int os::getch()
+int os::read_input(std::span<char> buffer, const int timeout_ms)
 {
-    char ch;
-    DWORD chars_read = 0;
+    // With virtual terminal input enabled, key presses arrive as a series of
+    // key events holding the individual characters of their VT sequences.
+    // Anything else in the input buffer (focus, mouse, and key up events)
+    // is consumed and dropped, so it can't keep the handle signalled.
     HANDLE input_handle = GetStdHandle(STD_INPUT_HANDLE);
-    ReadConsoleA(input_handle, &ch, 1, &chars_read, NULL);
-    return chars_read == 1 ? static_cast<int>(ch) : -1;
+    auto count = std::size_t{0};
+    auto timeout = static_cast<DWORD>(timeout_ms);
+    while (count < buffer.size() && WaitForSingleObject(input_handle, timeout) == WAIT_OBJECT_0) {
+        INPUT_RECORD records[16];
+        DWORD records_read = 0;
+        const auto max_records = static_cast<DWORD>(std::min(std::size(records), buffer.size() - count));
+        if (!ReadConsoleInputA(input_handle, records, max_records, &records_read)) break;
+        for (auto i = DWORD{0}; i < records_read; i++) {
+            const auto& record = records[i];
+            if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown) {
+                const auto ch = record.Event.KeyEvent.uChar.AsciiChar;
+                if (ch != 0) buffer[count++] = ch;
+            }
+        }
+        if (count > 0) break;
+        timeout = 0;
+    }
+    total_bytes_read += count;
+    return static_cast<int>(count);
+}
+
+int os::baud_rate()
+{
+    // The console doesn't have a meaningful line speed.
+    return 0;
+}
+
+std::string os::terminal_type()
+{
+    return "console";
+}
+
+std::string os::terminal_name()
+{
+    return {};
+}
+
+std::filesystem::path os::cache_path()
+{
+    auto path = std::filesystem::path{};
+    auto buffer = std::array<wchar_t, MAX_PATH>{};
+    const auto length = GetEnvironmentVariableW(L"LOCALAPPDATA", buffer.data(), static_cast<DWORD>(buffer.size()));
+    if (length > 0 && length < buffer.size())
+        path = std::filesystem::path{buffer.data()} / "vtinvaders";
+    return path;
 }
 
 #endif
 
 #ifdef __linux__
 
+#include <poll.h>
 #include <signal.h>
 #include <termios.h>
 #include <unistd.h>
 
-#include <cstdio>
+#include <cstdlib>
 
 struct termios term_attributes;
 
@@ -67,9 +128,65 @@ os::~os()
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &term_attributes);
 }
 
-int os::getch()
+int os::read_input(std::span<char> buffer, const int timeout_ms)
+{
+    auto fds = pollfd{STDIN_FILENO, POLLIN, 0};
+    if (poll(&fds, 1, timeout_ms) <= 0 || !(fds.revents & POLLIN)) return 0;
+    const auto result = read(STDIN_FILENO, buffer.data(), buffer.size());
+    if (result <= 0) return 0;
+    total_bytes_read += result;
+    return static_cast<int>(result);
+}
+
+int os::baud_rate()
+{
+    // Returns 0 if the speed isn't known.
+    auto attributes = termios{};
+    if (tcgetattr(STDOUT_FILENO, &attributes) != 0) return 0;
+    switch (cfgetospeed(&attributes)) {
+        case B300: return 300;
+        case B600: return 600;
+        case B1200: return 1200;
+        case B2400: return 2400;
+        case B4800: return 4800;
+        case B9600: return 9600;
+        case B19200: return 19200;
+        case B38400: return 38400;
+        case B57600: return 57600;
+        case B115200: return 115200;
+        case B230400: return 230400;
+        default: return 0;
+    }
+}
+
+std::string os::terminal_type()
+{
+    const auto term = getenv("TERM");
+    return term ? term : "";
+}
+
+std::string os::terminal_name()
+{
+    // Pseudo-terminal numbers are just allocated on a first come basis, so
+    // they don't tell us anything about the terminal on the other end.
+    const auto name = std::string{ttyname(STDIN_FILENO) ?: ""};
+    return name.starts_with("/dev/pts/") ? "/dev/pts" : name;
+}
+
+std::filesystem::path os::cache_path()
 {
-    return getchar();
+    // This follows the XDG base directory spec, falling back to ~/.cache if
+    // XDG_CACHE_HOME isn't set.
+    auto path = std::filesystem::path{};
+    const auto xdg_cache_home = getenv("XDG_CACHE_HOME");
+    const auto home = getenv("HOME");
+    if (xdg_cache_home && xdg_cache_home[0] == '/')
+        path = xdg_cache_home;
+    else if (home && home[0] == '/')
+        path = std::filesystem::path{home} / ".cache";
+    if (!path.empty())
+        path /= "vtinvaders";
+    return path;
 }
 
 #endif
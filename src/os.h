@@ -4,9 +4,18 @@
 
 #pragma once
 
+#include <filesystem>
+#include <span>
+#include <string>
+
 class os {
 public:
     os();
     ~os();
-    static int getch();
+    static int read_input(std::span<char> buffer, const int timeout_ms = 0);
+    static std::size_t bytes_read();
+    static int baud_rate();
+    static std::string terminal_type();
+    static std::string terminal_name();
+    static std::filesystem::path cache_path();
 };
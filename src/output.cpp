@@ -0,0 +1,345 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "output.h"
+
+#include <algorithm>
+#include <array>
+
+std::size_t sink::backlog() const
+{
+    return 0;
+}
+
+output::output(sink& sink)
+    : _sink{sink}
+{
+    _chunks.push_back(std::make_unique<char[]>(chunk_size));
+    _position = _chunks[0].get();
+    _limit = _position + chunk_size;
+}
+
+output::~output()
+{
+    flush();
+}
+
+void output::write(const std::string_view s)
+{
+    for (auto c : s)
+        write(c);
+}
+
+void output::write(const int n)
+{
+    auto digits = std::array<char, 11>{};
+    auto i = digits.size();
+    auto value = n < 0 ? 0u - static_cast<unsigned>(n) : static_cast<unsigned>(n);
+    do {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    if (n < 0) digits[--i] = '-';
+    write(std::string_view{&digits[i], digits.size() - i});
+}
+
+void output::flush()
+{
+    // Every chunk before the current one is full, so we only need to work out
+    // how much of the current chunk has been used.
+    _pieces.clear();
+    for (auto i = std::size_t{0}; i < _chunk_index; i++)
+        _pieces.emplace_back(_chunks[i].get(), chunk_size);
+    const auto current = _chunks[_chunk_index].get();
+    if (_position != current)
+        _pieces.emplace_back(current, _position - current);
+    if (!_pieces.empty())
+        _sink.write(_pieces);
+    _flushed_size += size();
+    _chunk_index = 0;
+    _position = _chunks[0].get();
+    _limit = _position + chunk_size;
+}
+
+std::size_t output::size() const
+{
+    const auto current = _chunks[_chunk_index].get();
+    return _chunk_index * chunk_size + (_position - current);
+}
+
+std::size_t output::total_size() const
+{
+    // The number of bytes written since construction, flushed or not.
+    return _flushed_size + size();
+}
+
+std::size_t output::backlog() const
+{
+    return _sink.backlog();
+}
+
+void output::_next_chunk()
+{
+    // Once a chunk has been allocated we keep it for reuse, so a busy frame
+    // may grow the buffer, but the steady state doesn't need to allocate.
+    if (++_chunk_index == _chunks.size())
+        _chunks.push_back(std::make_unique<char[]>(chunk_size));
+    _position = _chunks[_chunk_index].get();
+    _limit = _position + chunk_size;
+}
+
+async_sink::async_sink(sink& target)
+    : _target{target}, _ring{std::make_unique<char[]>(capacity)}
+{
+    _thread = std::thread([this]() { _run(); });
+}
+
+async_sink::~async_sink()
+{
+    drain();
+    _stopping = true;
+    _signal++;
+    _signal.notify_one();
+    _thread.join();
+}
+
+void async_sink::write(const std::span<const std::string_view> pieces)
+{
+    // This is only ever called from a single thread, so we're the only one
+    // updating the head, and the writer thread is the only one updating the
+    // tail. If the ring is full, we have no choice but to wait for the writer
+    // to catch up.
+    auto head = _head.load(std::memory_order_relaxed);
+    for (const auto piece : pieces) {
+        auto data = piece.data();
+        auto remaining = piece.size();
+        while (remaining > 0) {
+            auto tail = _tail.load(std::memory_order_acquire);
+            while (head - tail == capacity) {
+                _head.store(head, std::memory_order_release);
+                _signal++;
+                _signal.notify_one();
+                _tail.wait(tail, std::memory_order_acquire);
+                tail = _tail.load(std::memory_order_acquire);
+            }
+            const auto index = head % capacity;
+            const auto count = std::min({remaining, capacity - (head - tail), capacity - index});
+            std::copy_n(data, count, &_ring[index]);
+            data += count;
+            remaining -= count;
+            head += count;
+        }
+    }
+    // We add a marker recording when this output was queued, so the writer
+    // can later tell how long it took to get it out. If there's no space for
+    // a marker, the lag will just be measured against the next one instead.
+    const auto marker_head = _marker_head.load(std::memory_order_relaxed);
+    if (marker_head - _marker_tail.load(std::memory_order_acquire) < max_markers) {
+        _markers[marker_head % max_markers] = {head, clock::now()};
+        _marker_head.store(marker_head + 1, std::memory_order_release);
+    }
+    _head.store(head, std::memory_order_release);
+    _signal++;
+    _signal.notify_one();
+}
+
+std::size_t async_sink::backlog() const
+{
+    return queued_bytes() + _target.backlog();
+}
+
+void async_sink::drain()
+{
+    const auto head = _head.load(std::memory_order_acquire);
+    auto tail = _tail.load(std::memory_order_acquire);
+    while (tail != head) {
+        _tail.wait(tail, std::memory_order_acquire);
+        tail = _tail.load(std::memory_order_acquire);
+    }
+}
+
+std::size_t async_sink::queued_bytes() const
+{
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+async_sink::clock::duration async_sink::writer_lag() const
+{
+    return clock::duration{_lag.load(std::memory_order_relaxed)};
+}
+
+async_sink::clock::duration async_sink::max_writer_lag() const
+{
+    return clock::duration{_max_lag.load(std::memory_order_relaxed)};
+}
+
+void async_sink::_run()
+{
+    for (;;) {
+        // The signal must be read before checking for data, otherwise we
+        // could miss a notification that arrives in between.
+        const auto signal = _signal.load(std::memory_order_acquire);
+        const auto head = _head.load(std::memory_order_acquire);
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        if (head == tail) {
+            if (_stopping) break;
+            _signal.wait(signal, std::memory_order_acquire);
+            continue;
+        }
+        // The queued data may wrap around the end of the ring, in which case
+        // it's written out as two pieces.
+        const auto start = tail % capacity;
+        const auto size = head - tail;
+        const auto first_size = std::min(size, capacity - start);
+        const auto pieces = std::to_array<std::string_view>({
+            {&_ring[start], first_size},
+            {&_ring[0], size - first_size},
+        });
+        _target.write(std::span{pieces.data(), first_size < size ? 2u : 1u});
+        _tail.store(head, std::memory_order_release);
+        _tail.notify_all();
+        _record_lag(head);
+    }
+}
+
+void async_sink::_record_lag(const std::uint64_t written)
+{
+    const auto now = clock::now();
+    auto marker_tail = _marker_tail.load(std::memory_order_relaxed);
+    const auto marker_head = _marker_head.load(std::memory_order_acquire);
+    while (marker_tail != marker_head && _markers[marker_tail % max_markers].end <= written) {
+        const auto lag = (now - _markers[marker_tail % max_markers].time).count();
+        _lag.store(lag, std::memory_order_relaxed);
+        if (lag > _max_lag.load(std::memory_order_relaxed))
+            _max_lag.store(lag, std::memory_order_relaxed);
+        marker_tail++;
+    }
+    _marker_tail.store(marker_tail, std::memory_order_release);
+}
+
+void memory_sink::write(const std::span<const std::string_view> pieces)
+{
+    for (const auto piece : pieces)
+        _data += piece;
+}
+
+const std::string& memory_sink::data() const
+{
+    return _data;
+}
+
+void memory_sink::clear()
+{
+    _data.clear();
+}
+
+void null_sink::write(const std::span<const std::string_view> pieces)
+{
+    for (const auto piece : pieces)
+        _bytes_written += piece.size();
+}
+
+std::size_t null_sink::bytes_written() const
+{
+    return _bytes_written;
+}
+
+fd_sink::fd_sink(const int fd)
+    : _fd{fd}
+{
+}
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+void fd_sink::write(const std::span<const std::string_view> pieces)
+{
+    const auto handle = GetStdHandle(_fd == 2 ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+    for (const auto piece : pieces) {
+        auto data = piece.data();
+        auto remaining = piece.size();
+        while (remaining > 0) {
+            auto written = DWORD{0};
+            if (!WriteFile(handle, data, static_cast<DWORD>(remaining), &written, NULL)) return;
+            data += written;
+            remaining -= written;
+        }
+    }
+}
+
+std::size_t fd_sink::backlog() const
+{
+    return 0;
+}
+
+#endif
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+void fd_sink::write(const std::span<const std::string_view> pieces)
+{
+    // We gather as many pieces as we can into a single writev call. After a
+    // partial write, we skip over whatever was written and try again with
+    // the remainder.
+    constexpr auto max_vectors = 16;
+    auto vectors = std::array<iovec, max_vectors>{};
+    auto piece_index = std::size_t{0};
+    auto piece_offset = std::size_t{0};
+    while (piece_index < pieces.size()) {
+        if (piece_offset == pieces[piece_index].size()) {
+            piece_index++;
+            piece_offset = 0;
+            continue;
+        }
+        auto count = 0;
+        for (auto i = piece_index; i < pieces.size() && count < max_vectors; i++) {
+            const auto offset = (i == piece_index ? piece_offset : 0);
+            vectors[count].iov_base = const_cast<char*>(pieces[i].data() + offset);
+            vectors[count].iov_len = pieces[i].size() - offset;
+            count++;
+        }
+        auto written = ::writev(_fd, vectors.data(), count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // The descriptor is non-blocking and its buffer is full, so we
+                // wait until there is room to write again.
+                auto fds = pollfd{_fd, POLLOUT, 0};
+                ::poll(&fds, 1, -1);
+                continue;
+            }
+            return;
+        }
+        auto advance = static_cast<std::size_t>(written);
+        while (advance > 0) {
+            const auto remaining = pieces[piece_index].size() - piece_offset;
+            if (advance < remaining) {
+                piece_offset += advance;
+                advance = 0;
+            } else {
+                advance -= remaining;
+                piece_index++;
+                piece_offset = 0;
+            }
+        }
+    }
+}
+
+std::size_t fd_sink::backlog() const
+{
+    // For a terminal device, this tells us how much output is still sitting
+    // in the kernel's queue waiting to be transmitted.
+    auto queued = 0;
+    if (::ioctl(_fd, TIOCOUTQ, &queued) < 0) return 0;
+    return queued;
+}
+
+#endif
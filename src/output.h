@@ -0,0 +1,133 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class sink {
+public:
+    virtual ~sink() = default;
+    virtual void write(const std::span<const std::string_view> pieces) = 0;
+    virtual std::size_t backlog() const;
+};
+
+class fd_sink : public sink {
+public:
+    fd_sink(const int fd);
+    void write(const std::span<const std::string_view> pieces) override;
+    std::size_t backlog() const override;
+
+private:
+    const int _fd;
+};
+
+class async_sink : public sink {
+public:
+    using clock = std::chrono::steady_clock;
+
+    async_sink(sink& target);
+    ~async_sink();
+    void write(const std::span<const std::string_view> pieces) override;
+    std::size_t backlog() const override;
+    void drain();
+    std::size_t queued_bytes() const;
+    clock::duration writer_lag() const;
+    clock::duration max_writer_lag() const;
+
+private:
+    static constexpr std::size_t capacity = 65536;
+    static constexpr std::size_t max_markers = 64;
+
+    struct marker {
+        std::uint64_t end = 0;
+        clock::time_point time = {};
+    };
+
+    void _run();
+    void _record_lag(const std::uint64_t written);
+
+    sink& _target;
+    std::unique_ptr<char[]> _ring;
+    std::array<marker, max_markers> _markers = {};
+    std::atomic<std::uint64_t> _head = 0;
+    std::atomic<std::uint64_t> _tail = 0;
+    std::atomic<std::uint64_t> _marker_head = 0;
+    std::atomic<std::uint64_t> _marker_tail = 0;
+    std::atomic<std::uint32_t> _signal = 0;
+    std::atomic<bool> _stopping = false;
+    std::atomic<clock::rep> _lag = 0;
+    std::atomic<clock::rep> _max_lag = 0;
+    std::thread _thread;
+};
+
+class memory_sink : public sink {
+public:
+    void write(const std::span<const std::string_view> pieces) override;
+    const std::string& data() const;
+    void clear();
+
+private:
+    std::string _data;
+};
+
+class null_sink : public sink {
+public:
+    void write(const std::span<const std::string_view> pieces) override;
+    std::size_t bytes_written() const;
+
+private:
+    std::size_t _bytes_written = 0;
+};
+
+class output {
+public:
+    static constexpr std::size_t chunk_size = 4096;
+
+    output(sink& sink);
+    ~output();
+    output(const output&) = delete;
+    output& operator=(const output&) = delete;
+
+    void write(const char c)
+    {
+        if (_position == _limit) _next_chunk();
+        *_position++ = c;
+    }
+
+    void write(const std::string_view s);
+    void write(const int n);
+    void flush();
+    std::size_t size() const;
+    std::size_t total_size() const;
+    std::size_t backlog() const;
+
+    template <typename T>
+    output& operator<<(const T& value)
+    {
+        write(value);
+        return *this;
+    }
+
+private:
+    void _next_chunk();
+
+    sink& _sink;
+    std::vector<std::unique_ptr<char[]>> _chunks;
+    std::vector<std::string_view> _pieces;
+    std::size_t _chunk_index = 0;
+    std::size_t _flushed_size = 0;
+    char* _position = nullptr;
+    char* _limit = nullptr;
+};
@@ -0,0 +1,115 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "pacer.h"
+
+#include "output.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    constexpr auto min_spin_window = 50us;
+    constexpr auto initial_spin_window = 1ms;
+
+    int microseconds(const pacer::clock::duration duration)
+    {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+
+}  // namespace
+
+pacer::pacer(const int fps, const bool paced)
+    : _frame_len{std::chrono::duration_cast<clock::duration>(1000ms) / fps},
+      _paced{paced},
+      _spin_window{initial_spin_window}
+{
+}
+
+void pacer::start()
+{
+    _deadline = clock::now() + _frame_len;
+}
+
+int pacer::wait()
+{
+    // Returns how late the wait ended, in microseconds, which is how far the
+    // next frame start deviates from its schedule. When unpaced (i.e.
+    // benchmarking), frames run back to back.
+    if (!_paced) return 0;
+
+    // We sleep until shortly before the deadline, and then busy-wait for the
+    // remainder, since the sleep alone isn't accurate enough. The length of
+    // that final spin is calibrated from how late the sleep tends to wake up:
+    // it grows immediately after a late wake-up, and shrinks slowly otherwise.
+    const auto sleep_end = _deadline - _spin_window;
+    if (clock::now() < sleep_end) {
+        _sleep_until(sleep_end);
+        const auto oversleep = clock::now() - sleep_end;
+        _total_oversleep += oversleep;
+        _max_oversleep = std::max(_max_oversleep, oversleep);
+        const auto decayed = _spin_window - _spin_window / 64;
+        _spin_window = std::clamp<clock::duration>(std::max(oversleep, decayed), min_spin_window, _frame_len / 2);
+    }
+    const auto spin_start = clock::now();
+    while (clock::now() < _deadline) {
+    }
+    const auto now = clock::now();
+    const auto lateness = now - _deadline;
+    _wait_count++;
+    _total_lateness += lateness;
+    _max_lateness = std::max(_max_lateness, lateness);
+    _total_spin += std::max<clock::duration>(now - spin_start, {});
+
+    // The deadlines are absolute, so an occasional slow frame can be made up
+    // on the next one. But if we've fallen a whole frame behind (e.g. after
+    // a pause), we start the schedule again from now.
+    _deadline += _frame_len;
+    if (_deadline <= now) _deadline = now + _frame_len;
+    return microseconds(lateness);
+}
+
+void pacer::report(output& out) const
+{
+    const auto count = std::max(_wait_count, 1LL);
+    out << "Frame pacing: " << static_cast<int>(_wait_count) << " frames\n";
+    out << "  wake-up lateness (us): mean " << microseconds(_total_lateness / count);
+    out << ", max " << microseconds(_max_lateness) << '\n';
+    out << "  sleep overshoot (us): mean " << microseconds(_total_oversleep / count);
+    out << ", max " << microseconds(_max_oversleep) << '\n';
+    out << "  spin per frame (us): mean " << microseconds(_total_spin / count);
+    out << ", current window " << microseconds(_spin_window) << '\n';
+}
+
+#ifdef _WIN32
+
+void pacer::_sleep_until(const clock::time_point time)
+{
+    std::this_thread::sleep_until(time);
+}
+
+#endif
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <time.h>
+
+void pacer::_sleep_until(const clock::time_point time)
+{
+    // The steady_clock is based on CLOCK_MONOTONIC, so we can sleep until an
+    // absolute deadline without any conversion error accumulating.
+    const auto since_epoch = time.time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    auto deadline = timespec{};
+    deadline.tv_sec = seconds.count();
+    deadline.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count();
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
+
+#endif
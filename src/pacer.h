@@ -0,0 +1,33 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include <chrono>
+
+class output;
+
+class pacer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    pacer(const int fps, const bool paced = true);
+    void start();
+    int wait();
+    void report(output& out) const;
+
+private:
+    static void _sleep_until(const clock::time_point time);
+
+    const clock::duration _frame_len;
+    const bool _paced;
+    clock::time_point _deadline = {};
+    clock::duration _spin_window;
+    long long _wait_count = 0;
+    clock::duration _total_lateness = {};
+    clock::duration _max_lateness = {};
+    clock::duration _total_oversleep = {};
+    clock::duration _max_oversleep = {};
+    clock::duration _total_spin = {};
+};
@@ -0,0 +1,185 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "parser.h"
+
+#include <algorithm>
+
+int report::param(const std::size_t index, const int default_value) const
+{
+    return index < params.size() ? params[index] : default_value;
+}
+
+parser::parser(input_queue& input)
+    : _input{input}
+{
+    // This is enough for most reports, but a DECCTR report for a large color
+    // table can be longer, so the string is still allowed to grow.
+    _data.reserve(1024);
+}
+
+const report* parser::parse(const char ch)
+{
+    // XON and XOFF can turn up anywhere, and are simply ignored.
+    if (ch == '\021' || ch == '\023') return nullptr;
+
+    switch (_state) {
+        case state::ground:
+            if (ch == '\033')
+                _state = state::escape;
+            else
+                _key(ch);
+            return nullptr;
+        case state::escape:
+            _clear();
+            if (ch == '[')
+                _state = state::csi;
+            else if (ch == 'P')
+                _state = state::dcs;
+            else if (ch == ']')
+                _state = state::osc_string;
+            else if (ch != '\033') {
+                _state = state::ground;
+                _key(ch);
+            }
+            return nullptr;
+        case state::csi:
+            if (ch == '\033') {
+                _state = state::escape;
+            } else if (ch >= '@' && ch <= '~') {
+                _state = state::ground;
+                return _csi_dispatch(ch);
+            } else if (ch < ' ') {
+                // Control characters are executed in the middle of a sequence,
+                // so they're passed through as input.
+                _key(ch);
+            } else {
+                _param(ch);
+            }
+            return nullptr;
+        case state::dcs:
+            if (ch == '\033') {
+                _state = state::escape;
+            } else if (ch >= '@' && ch <= '~') {
+                _dcs_dispatch(ch);
+                _state = state::dcs_string;
+            } else if (ch >= ' ') {
+                _param(ch);
+            }
+            return nullptr;
+        case state::dcs_string:
+            if (ch == '\033')
+                _state = state::dcs_escape;
+            else if (_string_wanted)
+                _data.push_back(ch);
+            return nullptr;
+        case state::dcs_escape:
+            if (ch == '\\') {
+                _state = state::ground;
+                return _dcs_end();
+            }
+            // Anything other than ST aborts the string.
+            _state = state::escape;
+            return parse(ch);
+        case state::osc_string:
+            if (ch == '\033')
+                _state = state::osc_escape;
+            else if (ch == '\007')
+                _state = state::ground;
+            return nullptr;
+        case state::osc_escape:
+            if (ch == '\\') {
+                _state = state::ground;
+                return nullptr;
+            }
+            _state = state::escape;
+            return parse(ch);
+    }
+    return nullptr;
+}
+
+void parser::_clear()
+{
+    _prefix = 0;
+    _intermediate = 0;
+    _string_wanted = false;
+    _params[0] = 0;
+    _param_count = 0;
+    _data.clear();
+}
+
+void parser::_param(const char ch)
+{
+    // The Reflection Desktop terminal sometimes uses comma separators
+    // instead of semicolons in their DA report, so we allow for either.
+    if (ch >= '0' && ch <= '9') {
+        if (_param_count == 0) _param_count = 1;
+        auto& param = _params[_param_count - 1];
+        param = std::min(param * 10 + (ch - '0'), 65535);
+    } else if (ch == ';' || ch == ',') {
+        if (_param_count == 0) _param_count = 1;
+        if (_param_count < _params.size()) _params[_param_count++] = 0;
+    } else if (ch >= '<' && ch <= '?') {
+        _prefix = ch;
+    } else if (ch >= ' ' && ch <= '/') {
+        _intermediate = ch;
+    }
+}
+
+const report* parser::_csi_dispatch(const char final_char)
+{
+    const auto is = [&](const report_type type) {
+        _report.type = type;
+        _report.params = std::span{_params.data(), _param_count};
+        _report.data = {};
+        return &_report;
+    };
+    if (_intermediate == 0) {
+        if (_prefix == 0 && final_char == 'R' && _param_count == 2) return is(report_type::cpr);
+        if (_prefix == 0 && final_char == 'n') return is(report_type::dsr);
+        if (_prefix == '?' && final_char == 'c') return is(report_type::da1);
+        if (_prefix == '>' && final_char == 'c') return is(report_type::da2);
+    } else if (_intermediate == '$') {
+        if (_prefix == '?' && final_char == 'y') return is(report_type::decrpm);
+    }
+    // Anything else is assumed to be a key press, like the cursor keys.
+    if (_prefix == 0 && _intermediate == 0) _key(final_char);
+    return nullptr;
+}
+
+void parser::_dcs_dispatch(const char final_char)
+{
+    // We only keep the string data for the reports that we're interested in.
+    if (_prefix == 0 && _intermediate == '$') {
+        if (final_char == 'r') {
+            _report.type = report_type::decrqss;
+            _string_wanted = true;
+        } else if (final_char == 's') {
+            _report.type = report_type::decctr;
+            _string_wanted = true;
+        }
+    }
+}
+
+const report* parser::_dcs_end()
+{
+    if (!_string_wanted) return nullptr;
+    _report.params = std::span{_params.data(), _param_count};
+    _report.data = _data;
+    return &_report;
+}
+
+void parser::_key(const char ch)
+{
+    const auto now = input_event::clock::now();
+    if (ch == 32) {
+        _input.push({key::fire, now});
+    } else if (ch == 'C') {
+        _input.push({key::right, now});
+    } else if (ch == 'D') {
+        _input.push({key::left, now});
+    } else if (ch == 'q' || ch == 'Q' || ch == 3) {
+        _input.push({key::quit, now});
+    }
+}
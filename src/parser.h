@@ -0,0 +1,68 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include "input.h"
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+
+enum class report_type {
+    cpr,
+    dsr,
+    da1,
+    da2,
+    decrpm,
+    decrqss,
+    decctr
+};
+
+struct report {
+    report_type type = report_type::cpr;
+    std::span<const int> params;
+    std::string_view data;
+
+    int param(const std::size_t index, const int default_value = 0) const;
+};
+
+// An incremental parser for the reports that the terminal sends in response
+// to our queries. Characters are fed in one at a time, and anything that
+// isn't part of a report is treated as keyboard input.
+class parser {
+public:
+    parser(input_queue& input);
+    const report* parse(const char ch);
+
+private:
+    enum class state {
+        ground,
+        escape,
+        csi,
+        dcs,
+        dcs_string,
+        dcs_escape,
+        osc_string,
+        osc_escape
+    };
+
+    void _clear();
+    void _param(const char ch);
+    const report* _csi_dispatch(const char final_char);
+    void _dcs_dispatch(const char final_char);
+    const report* _dcs_end();
+    void _key(const char ch);
+
+    input_queue& _input;
+    state _state = state::ground;
+    char _prefix = 0;
+    char _intermediate = 0;
+    bool _string_wanted = false;
+    std::array<int, 16> _params = {};
+    std::size_t _param_count = 0;
+    std::string _data;
+    report _report;
+};
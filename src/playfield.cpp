@@ -0,0 +1,223 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "playfield.h"
+
+#include "aliens.h"
+#include "missiles.h"
+#include "shields.h"
+#include "turret.h"
+#include "ufo.h"
+
+#include <algorithm>
+
+color playfield::color_for_row(const int y)
+{
+    constexpr auto red_row = ufo::row;
+    constexpr auto green_row = shields::row - 1;
+    if (y <= red_row) return color::red;
+    if (y >= green_row) return color::green;
+    return color::white;
+}
+
+playfield::playfield()
+{
+    _state.ids.fill(no_id);
+}
+
+void playfield::set_renderer(renderer* renderer)
+{
+    _renderer = renderer;
+}
+
+void playfield::watch(const entity entity, overwrite_listener* listener)
+{
+    _listeners[static_cast<int>(entity)] = listener;
+}
+
+void playfield::reset()
+{
+    _state.ids.fill(no_id);
+    _state.bitboards = {};
+    clear_changes();
+    // The renderer erases everything other than the bottom row, so that is
+    // the only part of the playfield where the cell state is retained.
+    const auto erased = offset(height, 1);
+    std::fill_n(_state.desired.begin(), erased, blank);
+    if (_renderer) _renderer->reset();
+}
+
+void playfield::clear_line(const int y)
+{
+    if (_renderer) _renderer->clear_line(y);
+    std::fill_n(_state.desired.begin() + offset(y, 1), width, blank);
+}
+
+void playfield::double_width(const int y)
+{
+    if (_renderer) _renderer->double_width(y);
+}
+
+void playfield::single_width(const int y)
+{
+    if (_renderer) _renderer->single_width(y);
+}
+
+void playfield::pause(const int frames)
+{
+    if (_renderer) _renderer->pause(frames);
+}
+
+void playfield::write(const char c)
+{
+    _put(_state.cursor_y, _state.cursor_x, c, color::any);
+}
+
+void playfield::write(const int y, const int x, const char c, const color color, const int id)
+{
+    if (!_put(y, x, c, color)) return;
+    const auto offset = playfield::offset(y, x);
+    _set_id(offset, _is_blank(c) ? empty : id);
+    _state.sources[offset] = _source_for(id, _state.source);
+}
+
+void playfield::write(const int y, const int x, const std::string_view s, const color color, const int id)
+{
+    _put(y, x, unknown, color);
+    const auto source = _source_for(id, _state.source);
+    for (auto c : s) {
+        const auto offset = playfield::offset(_state.cursor_y, _state.cursor_x);
+        if (!_put(_state.cursor_y, _state.cursor_x, c, color)) continue;
+        _state.sources[offset] = source;
+        _set_id(offset, _is_blank(c) ? empty : id);
+    }
+}
+
+int playfield::at(const int y, const int x) const
+{
+    if (y < 1 || y > height) return empty;
+    if (x < 1 || x > width) return empty;
+    const auto id = _state.ids[offset(y, x)];
+    return id == no_id ? empty : id;
+}
+
+bool playfield::occupied(const int y, const int x) const
+{
+    if (y < 1 || y > height) return false;
+    if (x < 1 || x > width) return false;
+    const auto bit = std::uint64_t{1} << (x - 1);
+    for (auto i = 1; i < entity_count; i++)
+        if (_state.bitboards[i][y - 1] & bit) return true;
+    return false;
+}
+
+void playfield::set_source(const output_source source)
+{
+    // Cells written from now on are attributed to this source, unless the
+    // id they're written with says otherwise.
+    _state.source = source;
+}
+
+output_source playfield::source() const
+{
+    return _state.source;
+}
+
+const playfield::row_masks& playfield::changes() const
+{
+    return _changes;
+}
+
+void playfield::clear_changes()
+{
+    _changes = {};
+}
+
+playfield::state playfield::save() const
+{
+    return _state;
+}
+
+void playfield::restore(const state& state)
+{
+    // The listeners aren't notified of anything that is overwritten by the
+    // restore, since their own state is expected to be restored with it.
+    // Every cell is marked as changed, so an attached renderer will output
+    // whatever differs from what it currently has on the screen.
+    _state = state;
+    _changes.fill(~std::uint64_t{0} >> (64 - width));
+}
+
+bool playfield::_put(const int y, const int x, const char c, const color color)
+{
+    // Returns false if nothing was stored. Cells outside the playfield are
+    // skipped, but the cursor still moves on past them.
+    if (color != color::any) _state.cursor_color = color;
+    _state.cursor_y = y;
+    _state.cursor_x = x;
+    if (c == unknown) return false;
+    _state.cursor_x++;
+    if (y < 1 || y > height || x < 1 || x > width) return false;
+    // Blank cells look the same in any color, so we don't care which color
+    // they end up being rendered with.
+    const auto offset = playfield::offset(y, x);
+    auto& cell = _state.desired[offset];
+    cell.glyph = c;
+    cell.color = c != ' ' ? _state.cursor_color : color::any;
+    _state.sources[offset] = _state.source;
+    _changes[y - 1] |= std::uint64_t{1} << (x - 1);
+    return true;
+}
+
+void playfield::_set_id(const int offset, const int id)
+{
+    // This is only called for cells that _put has stored, so the offset is
+    // always inside the playfield. The bitboards only need updating when the
+    // entity class changes.
+    const auto previous = _state.ids[offset] == no_id ? empty : _state.ids[offset];
+    _state.ids[offset] = id == empty ? no_id : static_cast<std::uint8_t>(id);
+    const auto previous_entity = _entity_for(previous);
+    const auto new_entity = _entity_for(id);
+    if (previous_entity == new_entity) return;
+    const auto row = offset / width;
+    const auto bit = std::uint64_t{1} << (offset % width);
+    if (previous_entity != entity::none)
+        _state.bitboards[static_cast<int>(previous_entity)][row] &= ~bit;
+    if (new_entity != entity::none)
+        _state.bitboards[static_cast<int>(new_entity)][row] |= bit;
+    if (const auto listener = _listeners[static_cast<int>(previous_entity)])
+        listener->overwritten(row + 1, offset % width + 1, id);
+}
+
+entity playfield::_entity_for(const int id)
+{
+    if (id >= 0 && id < aliens::count) return entity::aliens;
+    switch (id) {
+        case aliens::explosion_id: return entity::aliens;
+        case missiles::id: return entity::missiles;
+        case shields::id: return entity::shields;
+        case turret::id: return entity::turret;
+        case ufo::id: return entity::ufo;
+        default: return entity::none;
+    }
+}
+
+output_source playfield::_source_for(const int id, const output_source fallback)
+{
+    switch (_entity_for(id)) {
+        case entity::aliens: return output_source::aliens;
+        case entity::missiles: return output_source::missiles;
+        case entity::shields: return output_source::shields;
+        case entity::turret: return output_source::turret;
+        case entity::ufo: return output_source::ufo;
+        default: return fallback;
+    }
+}
+
+bool playfield::_is_blank(const char c)
+{
+    // The `y` is part of a destroyed shield sprite that is effectively
+    // blank for the purposes of collision detection.
+    return c == ' ' || c == 'y';
+}
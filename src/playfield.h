@@ -0,0 +1,160 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+enum class color : std::uint8_t {
+    any,
+    white,
+    red,
+    green
+};
+
+// The game objects that the screen output is attributed to.
+enum class output_source : std::uint8_t {
+    aliens,
+    missiles,
+    laser,
+    turret,
+    ufo,
+    shields,
+    status,
+    other
+};
+
+// Bytes output per source, split between the cell content itself, and the
+// cursor movement and SGR changes needed to get it there.
+struct output_bytes {
+    static constexpr int source_count = static_cast<int>(output_source::other) + 1;
+
+    std::array<int, source_count> content = {};
+    std::array<int, source_count> overhead = {};
+};
+
+// The classes of object that are tracked for collision detection.
+enum class entity {
+    none,
+    aliens,
+    missiles,
+    shields,
+    turret,
+    ufo
+};
+
+// Notified when a cell occupied by a watched class of object is taken over
+// by something else, or erased.
+class overwrite_listener {
+public:
+    virtual ~overwrite_listener() = default;
+    virtual void overwritten(const int y, const int x, const int id) = 0;
+};
+
+// Receives the playfield changes that can't be expressed as cell updates.
+// Without a renderer attached, these only affect the playfield state.
+class renderer {
+public:
+    virtual ~renderer() = default;
+    virtual void reset() = 0;
+    virtual void clear_line(const int y) = 0;
+    virtual void double_width(const int y) = 0;
+    virtual void single_width(const int y) = 0;
+    virtual void pause(const int frames) = 0;
+};
+
+// The desired contents of the game area, along with the id of the object
+// occupying each cell, which is what the collision detection is based on.
+// The ids are stored as single bytes, and each class of object also has a
+// bitboard of the cells it occupies, with one word per row, so a cell can
+// be tested for any kind of occupant at once. Cells that have been written since the last render
+// are marked as changes, in a mask per row.
+class playfield {
+public:
+    static constexpr int empty = -1;
+    static constexpr int width = 60;
+    static constexpr int height = 24;
+    static constexpr int cells = width * height;
+    static constexpr int entity_count = static_cast<int>(entity::ufo) + 1;
+    static_assert(width <= 64, "each row mask must fit in 64 bits");
+
+    struct cell {
+        char glyph = 0;
+        ::color color = ::color::any;
+        bool operator==(const cell& other) const = default;
+    };
+
+    static constexpr char unknown = 0;
+    static constexpr cell blank = {' ', color::any};
+
+    // Bit n of a row mask represents column n + 1.
+    using row_masks = std::array<std::uint64_t, height>;
+
+    // All of the playfield content, without the renderer, listeners, and
+    // pending changes, so it can be copied as a block.
+    struct state {
+        int cursor_y = 1;
+        int cursor_x = 1;
+        color cursor_color = color::any;
+        output_source source = output_source::other;
+        std::array<std::uint8_t, cells> ids = {};
+        std::array<row_masks, entity_count> bitboards = {};
+        std::array<cell, cells> desired = {};
+        std::array<output_source, cells> sources = {};
+    };
+
+    static color color_for_row(const int y);
+
+    playfield();
+    void set_renderer(renderer* renderer);
+    void watch(const entity entity, overwrite_listener* listener);
+    void reset();
+    void clear_line(const int y);
+    void double_width(const int y);
+    void single_width(const int y);
+    void pause(const int frames);
+    void write(const char c);
+    void write(const int y, const int x, const char c, const color color = color::any, const int id = empty);
+    void write(const int y, const int x, const std::string_view s, const color color = color::any, const int id = empty);
+    int at(const int y, const int x) const;
+    bool occupied(const int y, const int x) const;
+    void set_source(const output_source source);
+    output_source source() const;
+
+    const row_masks& changes() const;
+    void clear_changes();
+    state save() const;
+    void restore(const state& state);
+
+    const cell& desired(const int offset) const
+    {
+        return _state.desired[offset];
+    }
+
+    output_source source(const int offset) const
+    {
+        return _state.sources[offset];
+    }
+
+    static int offset(const int y, const int x)
+    {
+        return (y - 1) * width + (x - 1);
+    }
+
+private:
+    static constexpr std::uint8_t no_id = 0xFF;
+
+    bool _put(const int y, const int x, const char c, const color color);
+    void _set_id(const int offset, const int id);
+    static entity _entity_for(const int id);
+    static output_source _source_for(const int id, const output_source fallback);
+    static bool _is_blank(const char c);
+
+    renderer* _renderer = nullptr;
+    std::array<overwrite_listener*, entity_count> _listeners = {};
+    state _state;
+    row_masks _changes = {};
+};
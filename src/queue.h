@@ -0,0 +1,40 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// A bounded lock-free queue, which is safe to use with a single producer
+// thread and a single consumer thread.
+template <typename T, std::size_t N>
+class spsc_queue {
+public:
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+    bool push(const T& value)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N) return false;
+        _items[head % N] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value)
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        value = _items[tail % N];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, N> _items = {};
+    alignas(64) std::atomic<std::size_t> _head = 0;
+    alignas(64) std::atomic<std::size_t> _tail = 0;
+};
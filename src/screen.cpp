@@ -7,121 +7,231 @@
 #include "capabilities.h"
 #include "engine.h"
 #include "options.h"
-#include "shields.h"
-#include "ufo.h"
+#include "output.h"
 
-#include <iostream>
+#include <algorithm>
+#include <bit>
 #include <thread>
+#include <utility>
 
 using namespace std::chrono_literals;
 
-color screen::color_for_row(const int y)
-{
-    constexpr auto red_row = ufo::row;
-    constexpr auto green_row = shields::row - 1;
-    if (y <= red_row) return color::red;
-    if (y >= green_row) return color::green;
-    return color::white;
-}
+namespace {
+
+    int digits(const int n)
+    {
+        return n < 10 ? 1 : (n < 100 ? 2 : 3);
+    }
+
+}  // namespace
 
-screen::screen(const capabilities& caps, const options& options)
-    : _using_colors{options.color && caps.has_color}, _fps{options.fps}
+screen::screen(const capabilities& caps, const options& options, output& output, playfield& playfield)
+    : _output{output},
+      _playfield{playfield},
+      _using_colors{options.color && caps.has_color},
+      _has_vt510_moves{caps.conformance_level >= 5},
+      _fps{options.fps},
+      _paced{!options.bench},
+      _width{caps.width},
+      _attributed_size{output.total_size()}
 {
     _ri = caps.has_8bit ? "\215" : "\033M";
     _csi = caps.has_8bit ? "\233" : "\033[";
+    _ri_size = caps.has_8bit ? 1 : 2;
+    _csi_size = caps.has_8bit ? 1 : 2;
     _y_indent = std::max((caps.height - engine::height) / 2, 0);
     _x_indent = std::max((caps.width - engine::width) / 4 * 2, 0);
-    _ids.resize(engine::width * engine::height);
+    _runs.reserve(engine::width * engine::height);
+    _playfield.set_renderer(this);
+}
+
+screen::~screen()
+{
+    _playfield.set_renderer(nullptr);
 }
 
 void screen::reset()
 {
-    std::fill(_ids.begin(), _ids.end(), empty);
-    std::fill(_wide.begin(), _wide.end(), false);
-    _last_y = -1;
-    _last_x = -1;
-    _last_color = color::any;
+    _state.wide = {};
+    _state.last_y = -1;
+    _state.last_x = -1;
+    _state.last_color = color::any;
     _sgr(color::white);
     _write(_csi, _y_indent + engine::height - 1, ";999H");
     _write(_csi, "1J");
+    // The erase covers everything other than the bottom row, so that is the
+    // only part of the screen where the cell state may still be of interest.
+    const auto erased = playfield::offset(engine::height, 1);
+    std::fill_n(_state.current.begin(), erased, blank);
+    _attribute_overhead(_playfield.source());
     pause(1);
 }
 
 void screen::clear_line(const int y)
 {
+    _emit();
     _cup(y, 1);
     _write(_csi, 'K');
+    _attribute_overhead(_playfield.source());
+    std::fill_n(_state.current.begin() + playfield::offset(y, 1), engine::width, blank);
 }
 
 void screen::double_width(const int y)
 {
+    _emit();
     _cup(y, 1);
     _write("\033#6");
-    _wide[y - 1] = true;
+    _attribute_overhead(_playfield.source());
+    _state.wide[y - 1] = true;
+    // Anything in the right half of the line is lost when it becomes double
+    // width, so we can no longer be sure what those cells contain, unless
+    // they were already blank.
+    const auto offset = playfield::offset(y, engine::width / 2 + 1);
+    for (auto i = offset; i < offset + engine::width / 2; i++)
+        if (_state.current[i] != blank) _state.current[i].glyph = unknown;
 }
 
 void screen::single_width(const int y)
 {
+    _emit();
     _cup(y, 1);
     _write("\033#5");
-    _wide[y - 1] = false;
+    _attribute_overhead(_playfield.source());
+    _state.wide[y - 1] = false;
 }
 
-void screen::write(const char c)
+void screen::pause(const int frames)
 {
-    _write(c);
-    _last_x++;
+    // A pause always outputs the pending changes, regardless of whether the
+    // terminal has caught up, since we're going to be waiting anyway.
+    _emit();
+    _output.flush();
+    const auto frame_len = 1000ms / _fps;
+    if (_paced) std::this_thread::sleep_for(frames * frame_len);
 }
 
-void screen::write(const int y, const int x, const char c, const color color, const int id)
+void screen::flush()
 {
-    const auto offset = _offset(y, x);
-    _sgr(color);
-    _cup(y, x);
-    _write(c);
-    _last_x++;
-    _ids[offset] = _is_blank(c) ? empty : id;
+    // If the terminal hasn't received everything from the previous frame, we
+    // hold back our changes, leaving them queued in the cell grid. Once the
+    // output has drained, everything that changed in the meantime goes out as
+    // a single update, so the display is never more than a frame behind.
+    if (_output.backlog() > 0) return;
+    _emit();
+    _output.flush();
 }
 
-void screen::write(const int y, const int x, const std::string_view s, const color color, const int id)
+output_bytes screen::take_output_bytes()
 {
-    auto offset = _offset(y, x);
-    _sgr(color);
-    _cup(y, x);
-    for (auto c : s) {
-        _write(c);
-        _last_x++;
-        _ids[offset++] = _is_blank(c) ? empty : id;
+    return std::exchange(_output_bytes, {});
+}
+
+screen::state screen::save() const
+{
+    return _state;
+}
+
+void screen::restore(const state& state)
+{
+    _state = state;
+}
+
+void screen::_emit()
+{
+    // The changed cells are grouped into runs of consecutive changes on the
+    // same row. Cells that were written, but ended up matching what is
+    // already on the screen, don't need to be output at all.
+    const auto& changes = _playfield.changes();
+    _runs.clear();
+    for (auto row = 0; row < engine::height; row++) {
+        for (auto mask = changes[row]; mask; mask &= mask - 1) {
+            const auto offset = row * engine::width + std::countr_zero(mask);
+            if (!_changed(offset)) continue;
+            const auto same_row = !_runs.empty() && _runs.back().begin / engine::width == row;
+            if (same_row && _runs.back().end == offset)
+                _runs.back().end++;
+            else
+                _runs.push_back({offset, offset + 1});
+        }
+    }
+    _playfield.clear_changes();
+
+    // We then output the runs in a top-to-bottom sweep, but at each step we
+    // look a few runs ahead, and choose the one that requires the fewest
+    // bytes of cursor movement and SGR changes to reach from the current
+    // position. Ties are resolved in favor of the earlier run. The chosen
+    // run is swapped with the first pending run, so it can be dropped from
+    // the front without shifting the rest.
+    for (auto next = std::size_t{0}; next < _runs.size(); next++) {
+        const auto window_end = std::min(next + lookahead, _runs.size());
+        auto best = next;
+        auto best_cost = window_end - next > 1 ? _run_cost(_runs[next]) : 0;
+        for (auto i = next + 1; i < window_end && best_cost > 0; i++) {
+            const auto cost = _run_cost(_runs[i]);
+            if (cost < best_cost) {
+                best = i;
+                best_cost = cost;
+            }
+        }
+        std::swap(_runs[next], _runs[best]);
+        _emit_run(_runs[next]);
     }
 }
 
-void screen::pause(const int frames)
+bool screen::_changed(const int offset) const
 {
-    flush();
-    const auto frame_len = 1000ms / _fps;
-    std::this_thread::sleep_for(frames * frame_len);
+    // On a double-width row, only the left half of the cells are visible.
+    const auto wide = _state.wide[offset / engine::width];
+    if (wide && offset % engine::width >= engine::width / 2) return false;
+    const auto& desired = _playfield.desired(offset);
+    return desired.glyph != unknown && _effective(desired) != _state.current[offset];
 }
 
-void screen::flush()
+int screen::_run_cost(const run& run) const
 {
-    if (_buffer_index) {
-        std::cout.write(&_buffer[0], _buffer_index);
-        std::cout.flush();
-        _buffer_index = 0;
+    const auto y = run.begin / engine::width + 1;
+    const auto x = run.begin % engine::width + 1;
+    const auto wide = _state.wide[y - 1];
+    const auto abs_y = y + _y_indent;
+    const auto abs_x = x + (wide ? (_x_indent >> 1) : _x_indent);
+    // The SGR is output before the cursor is moved, so the move is planned
+    // with the color that will be active by then.
+    const auto color = _playfield.desired(run.begin).color;
+    const auto active_color = _color_after_sgr(color);
+    const auto move_cost = (abs_y == _state.last_y && abs_x == _state.last_x) ? 0 : _plan(abs_y, abs_x, active_color).cost;
+    return move_cost + _sgr_cost(color);
+}
+
+void screen::_emit_run(const run& run)
+{
+    const auto y = run.begin / engine::width + 1;
+    const auto x = run.begin % engine::width + 1;
+    _sgr(_playfield.desired(run.begin).color);
+    _cup(y, x);
+    _attribute_overhead(_playfield.source(run.begin));
+    for (auto offset = run.begin; offset < run.end; offset++) {
+        const auto& desired = _playfield.desired(offset);
+        const auto source = _playfield.source(offset);
+        _sgr(desired.color);
+        _attribute_overhead(source);
+        _write(desired.glyph);
+        _attribute_content(source);
+        _advance();
+        _state.current[offset] = _effective(desired);
     }
 }
 
-int screen::at(const int y, const int x) const
+screen::cell screen::_effective(const cell& cell) const
 {
-    if (y < 1 || y > engine::height) return empty;
-    if (x < 1 || x > engine::width) return empty;
-    return _ids[_offset(y, x)];
+    // The playfield has the colors the objects were written with, but they
+    // are only rendered if we're using colors.
+    return _using_colors ? cell : playfield::cell{cell.glyph, color::any};
 }
 
 void screen::_sgr(const color color)
 {
-    if (_using_colors && color != color::any && color != _last_color) {
-        _last_color = color;
+    if (_using_colors && color != color::any && color != _state.last_color) {
+        _state.last_color = color;
         switch (color) {
             case color::white:
                 _write(_csi, 'm');
@@ -136,66 +246,235 @@ void screen::_sgr(const color color)
     }
 }
 
+int screen::_sgr_cost(const color color) const
+{
+    if (_using_colors && color != color::any && color != _state.last_color)
+        return _csi_size + (color == color::white ? 0 : 2) + 1;
+    return 0;
+}
+
+color screen::_color_after_sgr(const color color) const
+{
+    return _using_colors && color != color::any ? color : _state.last_color;
+}
+
 void screen::_cup(const int y, const int x)
 {
-    const auto wide = _wide[y - 1];
+    const auto wide = _state.wide[y - 1];
     const auto abs_y = y + _y_indent;
     const auto abs_x = x + (wide ? (_x_indent >> 1) : _x_indent);
-    const auto unknown = _last_y == -1 || _last_x == -1;
-    auto diff_y = unknown ? 9999 : abs_y - _last_y;
-    auto diff_x = unknown ? 9999 : abs_x - _last_x;
-    if (diff_y || diff_x) {
-        if (abs(diff_y) > 2 && abs(diff_x) > 2)
-            _write(_csi, abs_y, ';', abs_x, 'H');
-        else {
-            // When moving from a double-width row, we need to move vertically
-            // first, because the horizontal movement may otherwise be clamped.
-            // It's the other way around when not on a double-width row, since
-            // if we move vertically first, the x oordinate may end up clamped
-            // on the target row before we have a chance to reposition it.
-            const auto last_y_index = _last_y - _y_indent - 1;
-            const auto last_was_wide = last_y_index >= 0 ? _wide[last_y_index] : false;
-            if (last_was_wide) {
-                _move_y_relative(diff_y);
-                _move_x_relative(diff_x);
-            } else {
-                _move_x_relative(diff_x);
-                _move_y_relative(diff_y);
+    if (abs_y == _state.last_y && abs_x == _state.last_x) return;
+
+    const auto best = _plan(abs_y, abs_x, _state.last_color);
+    if (best.moves[0] == move::cup) {
+        _write(_csi);
+        if (abs_y != 1) _write(abs_y);
+        if (abs_x != 1) _write(';', abs_x);
+        _write('H');
+        _state.last_y = abs_y;
+        _state.last_x = abs_x;
+    } else {
+        for (const auto m : best.moves)
+            _move(m, abs_y, abs_x);
+    }
+}
+
+screen::path screen::_plan(const int abs_y, const int abs_x, const color active_color) const
+{
+    // An absolute CUP is our fallback, and the only option available if we
+    // don't know where the cursor currently is. Default parameters of 1 can
+    // be omitted from the sequence.
+    const auto cup_cost = _csi_size + (abs_y == 1 ? 0 : digits(abs_y)) + (abs_x == 1 ? 0 : 1 + digits(abs_x)) + 1;
+    auto best = path{cup_cost, {move::cup}};
+
+    if (_state.last_y != -1 && _state.last_x != -1) {
+        constexpr auto vertical_moves = std::to_array({
+            move::none, move::vt, move::ri, move::cud, move::cuu, move::vpa, move::cnl, move::cpl});
+        const auto target_margin = _right_margin(abs_y);
+
+        // When moving vertically first, the column may end up clamped if the
+        // target is a double-width row, and CNL and CPL will always take us
+        // to the start of the line, so the horizontal movement needs to be
+        // calculated from wherever that leaves us.
+        for (const auto v : vertical_moves) {
+            const auto v_cost = _cost(v, _state.last_y, abs_y, abs_y, active_color);
+            if (v_cost >= best.cost) continue;
+            const auto from_x = (v == move::cnl || v == move::cpl) ? 1 : std::min(_state.last_x, target_margin);
+            const auto h = _horizontal_path(from_x, abs_x, abs_y, active_color);
+            if (v_cost + h.cost < best.cost)
+                best = {v_cost + h.cost, {v, h.moves[0], h.moves[1]}};
+        }
+
+        // Moving horizontally first is only an option if the target column is
+        // reachable on both rows, otherwise it would be clamped either before
+        // or after the vertical movement.
+        if (abs_y != _state.last_y && abs_x <= _right_margin(_state.last_y) && abs_x <= target_margin) {
+            const auto h = _horizontal_path(_state.last_x, abs_x, _state.last_y, active_color);
+            for (const auto v : vertical_moves) {
+                if (v == move::cnl || v == move::cpl) continue;
+                const auto cost = h.cost + _cost(v, _state.last_y, abs_y, abs_y, active_color);
+                if (cost < best.cost)
+                    best = {cost, {h.moves[0], h.moves[1], v}};
             }
         }
-        _last_y = abs_y;
-        _last_x = abs_x;
     }
+
+    return best;
+}
+
+screen::path screen::_horizontal_path(const int from_x, const int to_x, const int y, const color active_color) const
+{
+    constexpr auto direct_moves = std::to_array({
+        move::none, move::bs, move::cub, move::cuf, move::reprint, move::cha});
+    auto best = path{impossible};
+    for (const auto m : direct_moves) {
+        const auto cost = _cost(m, from_x, to_x, y, active_color);
+        if (cost < best.cost) best = {cost, {m}};
+    }
+    // When moving backwards, it may be cheaper to return to the start of the
+    // line with a CR, and then move forward from there.
+    if (to_x < from_x) {
+        for (const auto m : {move::none, move::cuf, move::reprint}) {
+            const auto cost = 1 + _cost(m, 1, to_x, y, active_color);
+            if (cost < best.cost) best = {cost, {move::cr, m}};
+        }
+    }
+    return best;
+}
+
+int screen::_cost(const move move, const int from, const int to, const int y, const color active_color) const
+{
+    const auto distance = std::abs(to - from);
+    const auto sequence_cost = [&](const int n) {
+        return _csi_size + (n == 1 ? 0 : digits(n)) + 1;
+    };
+    switch (move) {
+        case move::none: return from == to ? 0 : impossible;
+        case move::cr: return 1;
+        case move::bs: return to < from ? distance : impossible;
+        case move::cub: return to < from ? sequence_cost(distance) : impossible;
+        case move::cuf: return to > from ? sequence_cost(distance) : impossible;
+        case move::cha: return _has_vt510_moves ? sequence_cost(to) : impossible;
+        case move::reprint: return to > from && _can_reprint(y, from, to, active_color) ? distance : impossible;
+        case move::vt: return to > from ? distance : impossible;
+        case move::ri: return to < from ? distance * _ri_size : impossible;
+        case move::cud: return to > from ? sequence_cost(distance) : impossible;
+        case move::cuu: return to < from ? sequence_cost(distance) : impossible;
+        case move::vpa: return _has_vt510_moves && to != from ? sequence_cost(to) : impossible;
+        case move::cnl: return _has_vt510_moves && to > from ? sequence_cost(distance) : impossible;
+        case move::cpl: return _has_vt510_moves && to < from ? sequence_cost(distance) : impossible;
+        default: return impossible;
+    }
+}
+
+void screen::_move(const move move, const int y, const int x)
+{
+    switch (move) {
+        case move::none:
+        case move::cup:
+            // A CUP is output directly by _cup, so it never gets here.
+            break;
+        case move::cr:
+            _write('\r');
+            _state.last_x = 1;
+            break;
+        case move::bs:
+            for (; _state.last_x > x; _state.last_x--)
+                _write('\b');
+            break;
+        case move::cub:
+            _write_sequence(_state.last_x - x, 'D');
+            _state.last_x = x;
+            break;
+        case move::cuf:
+            _write_sequence(x - _state.last_x, 'C');
+            _state.last_x = x;
+            break;
+        case move::cha:
+            _write_sequence(x, 'G');
+            _state.last_x = x;
+            break;
+        case move::reprint: {
+            const auto row = _state.last_y - _y_indent;
+            const auto indent = _state.wide[row - 1] ? (_x_indent >> 1) : _x_indent;
+            for (; _state.last_x < x; _state.last_x++)
+                _write(_state.current[playfield::offset(row, _state.last_x - indent)].glyph);
+            break;
+        }
+        case move::vt:
+            for (; _state.last_y < y; _state.last_y++)
+                _write('\v');
+            break;
+        case move::ri:
+            for (; _state.last_y > y; _state.last_y--)
+                _write(_ri);
+            break;
+        case move::cud:
+            _write_sequence(y - _state.last_y, 'B');
+            _state.last_y = y;
+            break;
+        case move::cuu:
+            _write_sequence(_state.last_y - y, 'A');
+            _state.last_y = y;
+            break;
+        case move::vpa:
+            _write_sequence(y, 'd');
+            _state.last_y = y;
+            break;
+        case move::cnl:
+            _write_sequence(y - _state.last_y, 'E');
+            _state.last_y = y;
+            _state.last_x = 1;
+            break;
+        case move::cpl:
+            _write_sequence(_state.last_y - y, 'F');
+            _state.last_y = y;
+            _state.last_x = 1;
+            break;
+    }
+    // Vertical movement onto a double-width row can clamp the column.
+    _state.last_x = std::min(_state.last_x, _right_margin(_state.last_y));
+}
+
+bool screen::_can_reprint(const int y, const int from_x, const int to_x, const color active_color) const
+{
+    // We can move the cursor forward by rewriting the characters that are
+    // already on the screen, but only if we know what they are, and they're
+    // rendered in the currently active color.
+    const auto row = y - _y_indent;
+    if (row < 1 || row > engine::height) return false;
+    const auto wide = _state.wide[row - 1];
+    const auto indent = wide ? (_x_indent >> 1) : _x_indent;
+    const auto width = wide ? engine::width / 2 : engine::width;
+    if (from_x - indent < 1 || to_x - indent - 1 > width) return false;
+    const auto offset = playfield::offset(row, from_x - indent);
+    for (auto i = 0; i < to_x - from_x; i++) {
+        const auto& cell = _state.current[offset + i];
+        if (cell.glyph == unknown) return false;
+        if (cell.glyph != ' ' && cell.color != active_color) return false;
+    }
+    return true;
+}
+
+int screen::_right_margin(const int y) const
+{
+    const auto row = y - _y_indent;
+    const auto wide = row >= 1 && row <= engine::height && _state.wide[row - 1];
+    return wide ? _width / 2 : _width;
 }
 
-void screen::_move_y_relative(const int diff_y)
+void screen::_advance()
 {
-    if (diff_y == -1)
-        _write(_ri);
-    else if (diff_y == -2)
-        _write(_ri, _ri);
-    else if (diff_y == 1)
-        _write('\v');
-    else if (diff_y == 2)
-        _write("\v\v");
-    else if (diff_y > 0)
-        _write(_csi, diff_y, 'B');
-    else if (diff_y < 0)
-        _write(_csi, -diff_y, 'A');
+    // With line wrapping disabled, the cursor doesn't move past the right
+    // margin, so subsequent output will just overwrite the last column.
+    _state.last_x = std::min(_state.last_x + 1, _right_margin(_state.last_y));
 }
 
-void screen::_move_x_relative(const int diff_x)
+void screen::_write_sequence(const int n, const char final)
 {
-    if (diff_x == -1)
-        _write('\b');
-    else if (diff_x == -2)
-        _write("\b\b");
-    else if (diff_x == 1)
-        _write(_csi, 'C');
-    else if (diff_x > 0)
-        _write(_csi, diff_x, 'C');
-    else if (diff_x < 0)
-        _write(_csi, -diff_x, 'D');
+    _write(_csi);
+    if (n != 1) _write(n);
+    _write(final);
 }
 
 void screen::_write()
@@ -205,33 +484,36 @@ void screen::_write()
 template <typename... Args>
 void screen::_write(const int n, Args... args)
 {
-    _write(std::to_string(n));
+    _output.write(n);
     _write(args...);
 }
 
 template <typename... Args>
 void screen::_write(const std::string_view s, Args... args)
 {
-    for (auto c : s)
-        _write(c);
+    _output.write(s);
     _write(args...);
 }
 
 template <typename... Args>
 void screen::_write(const char c, Args... args)
 {
-    _buffer[_buffer_index++] = c;
+    _output.write(c);
     _write(args...);
 }
 
-bool screen::_is_blank(const char c)
+void screen::_attribute_overhead(const output_source source)
 {
-    // The `y` is part of a destroyed shield sprite that is effectively
-    // blank for the purposes of collision detection.
-    return c == ' ' || c == 'y';
+    // Everything output since the last attribution is assigned to the given
+    // source, since the screen is the only thing writing while a game runs.
+    const auto size = _output.total_size();
+    _output_bytes.overhead[static_cast<int>(source)] += static_cast<int>(size - _attributed_size);
+    _attributed_size = size;
 }
 
-int screen::_offset(const int y, const int x)
+void screen::_attribute_content(const output_source source)
 {
-    return (y - 1) * engine::width + (x - 1);
+    const auto size = _output.total_size();
+    _output_bytes.content[static_cast<int>(source)] += static_cast<int>(size - _attributed_size);
+    _attributed_size = size;
 }
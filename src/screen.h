@@ -4,43 +4,96 @@
 
 #pragma once
 
+#include "playfield.h"
+
 #include <array>
 #include <string_view>
+#include <type_traits>
 #include <vector>
 
 class capabilities;
 class options;
+class output;
 
-enum class color {
-    any,
-    white,
-    red,
-    green
-};
-
-class screen {
+// Renders the playfield changes to the terminal, keeping track of what is
+// currently on the screen so only the differences need to be output.
+class screen : public renderer {
 public:
-    static constexpr int empty = -1;
+    // What is believed to be on the terminal, so a restored screen can carry
+    // on from where it was saved without a full redraw.
+    struct state {
+        int last_y = -1;
+        int last_x = -1;
+        color last_color = color::any;
+        std::array<playfield::cell, playfield::cells> current = {};
+        std::array<bool, playfield::height> wide = {};
+    };
 
-    static color color_for_row(const int y);
-
-    screen(const capabilities& caps, const options& options);
-    void reset();
-    void clear_line(const int y);
-    void double_width(const int y);
-    void single_width(const int y);
-    void write(const char c);
-    void write(const int y, const int x, const char c, const color color = color::any, const int id = empty);
-    void write(const int y, const int x, const std::string_view s, const color color = color::any, const int id = empty);
-    void pause(const int frames);
+    screen(const capabilities& caps, const options& options, output& output, playfield& playfield);
+    ~screen();
+    void reset() override;
+    void clear_line(const int y) override;
+    void double_width(const int y) override;
+    void single_width(const int y) override;
+    void pause(const int frames) override;
     void flush();
-    int at(const int y, const int x) const;
+    output_bytes take_output_bytes();
+    state save() const;
+    void restore(const state& state);
 
 private:
+    using cell = playfield::cell;
+
+    enum class move {
+        none,
+        cup,
+        cr,
+        bs,
+        cub,
+        cuf,
+        cha,
+        reprint,
+        vt,
+        ri,
+        cud,
+        cuu,
+        vpa,
+        cnl,
+        cpl
+    };
+
+    struct path {
+        int cost = 0;
+        std::array<move, 3> moves = {};
+    };
+
+    struct run {
+        int begin = 0;
+        int end = 0;
+    };
+
+    static constexpr char unknown = playfield::unknown;
+    static constexpr int impossible = 9999;
+    static constexpr std::size_t lookahead = 8;
+    static constexpr cell blank = playfield::blank;
+
+    void _emit();
+    cell _effective(const cell& cell) const;
+    bool _changed(const int offset) const;
+    int _run_cost(const run& run) const;
+    void _emit_run(const run& run);
     void _sgr(const color color);
+    int _sgr_cost(const color color) const;
+    color _color_after_sgr(const color color) const;
     void _cup(const int y, const int x);
-    void _move_y_relative(const int diff_y);
-    void _move_x_relative(const int diff_y);
+    path _plan(const int abs_y, const int abs_x, const color active_color) const;
+    path _horizontal_path(const int from_x, const int to_x, const int y, const color active_color) const;
+    int _cost(const move move, const int from, const int to, const int y, const color active_color) const;
+    void _move(const move move, const int y, const int x);
+    void _write_sequence(const int n, const char final);
+    bool _can_reprint(const int y, const int from_x, const int to_x, const color active_color) const;
+    int _right_margin(const int y) const;
+    void _advance();
     void _write();
     template <typename... Args>
     void _write(const int n, Args... args);
@@ -48,20 +101,26 @@ private:
     void _write(const std::string_view s, Args... args);
     template <typename... Args>
     void _write(const char c, Args... args);
-    static bool _is_blank(const char c);
-    static int _offset(const int y, const int x);
+    void _attribute_overhead(const output_source source);
+    void _attribute_content(const output_source source);
 
+    output& _output;
+    playfield& _playfield;
     const bool _using_colors;
+    const bool _has_vt510_moves;
     const int _fps;
+    const bool _paced;
+    const int _width;
     const char* _ri;
     const char* _csi;
+    int _ri_size;
+    int _csi_size;
     int _y_indent;
     int _x_indent;
-    int _last_y = -1;
-    int _last_x = -1;
-    color _last_color = color::any;
-    std::vector<int> _ids = {};
-    std::array<bool, 24> _wide = {};
-    std::array<char, 256> _buffer = {};
-    int _buffer_index = 0;
+    state _state;
+    output_bytes _output_bytes = {};
+    std::size_t _attributed_size = 0;
+    std::vector<run> _runs = {};
 };
+
+static_assert(std::is_trivially_copyable_v<screen::state>);
@@ -4,9 +4,11 @@
 
 #include "shields.h"
 
-#include "screen.h"
+#include "font.h"
+#include "playfield.h"
 
 #include <algorithm>
+#include <utility>
 
 namespace {
 
@@ -27,53 +29,86 @@ namespace {
 
 }  // namespace
 
-shields::shields(screen& screen)
-    : _screen{screen}
+glyph_set shields::glyphs()
 {
+    auto glyphs = glyph_set{};
+    glyphs.add(top_shield_sprite);
+    glyphs.add(top_damage_sprites);
+    glyphs.add(bottom_shield_sprite);
+    glyphs.add(bottom_damage_sprites);
+    return glyphs;
+}
+
+shields::shields(playfield& playfield)
+    : _playfield{playfield}
+{
+    _playfield.watch(entity::shields, this);
+}
+
+shields::~shields()
+{
+    _playfield.watch(entity::shields, nullptr);
 }
 
 void shields::reset()
 {
-    for (auto n = 0; n < _shields.size(); n++) {
-        _shields[n].reset(n, _screen);
-        _screen.pause(1);
+    for (auto n = 0; n < _state.shields.size(); n++) {
+        _state.shields[n].reset(n, _playfield);
+        _playfield.pause(1);
     }
+    _state.overwrites_pending = false;
 }
 
 void shields::update()
 {
-    for (auto& shield : _shields)
-        shield.update(_screen);
+    // Overwritten cells are only recorded as damage once per frame, so a
+    // second hit in the same frame sees the same state as before.
+    if (!_state.overwrites_pending) return;
+    for (auto& shield : _state.shields)
+        shield.update();
+    _state.overwrites_pending = false;
 }
 
 void shields::hit(const bool from_above, const int x)
 {
-    for (auto& shield : _shields)
-        shield.hit(from_above, x, _screen);
+    for (auto& shield : _state.shields)
+        shield.hit(from_above, x, _playfield);
 }
 
-void shields::instance::reset(const int n, screen& screen)
+void shields::overwritten(const int y, const int x, const int)
+{
+    for (auto& shield : _state.shields)
+        shield.overwritten(y, x);
+    _state.overwrites_pending = true;
+}
+
+void shields::instance::reset(const int n, playfield& playfield)
 {
     _y = shields::row;
     _x = 11 + n * 12;
     std::fill(_damage.begin(), _damage.end(), 0);
-    screen.write(_y, _x, top_shield_sprite, color::green, shields::id);
-    screen.write(_y + 1, _x, bottom_shield_sprite, color::green, shields::id);
+    std::fill(_overwritten.begin(), _overwritten.end(), 0);
+    playfield.write(_y, _x, top_shield_sprite, color::green, shields::id);
+    playfield.write(_y + 1, _x, bottom_shield_sprite, color::green, shields::id);
 }
 
-void shields::instance::update(screen& screen)
+void shields::instance::update()
 {
-    for (auto column = 0; column < 4; column++) {
-        const auto x = _x + column;
-        auto& damage = _damage[column];
-        if ((~damage & 0b1100) && screen.at(_y, x) != shields::id)
-            damage |= 0b1100;
-        if ((~damage & 0b0011) && screen.at(_y + 1, x) != shields::id)
-            damage |= 0b0011;
+    // Any part of the shield that has been overwritten by something else
+    // is treated as destroyed.
+    for (auto column = 0; column < 4; column++)
+        _damage[column] |= std::exchange(_overwritten[column], 0);
+}
+
+void shields::instance::overwritten(const int y, const int x)
+{
+    if (x >= _x && x < _x + 4) {
+        if (y == _y) _overwritten[x - _x] |= 0b1100;
+        if (y == _y + 1) _overwritten[x - _x] |= 0b0011;
     }
 }
 
-void shields::instance::hit(const bool from_above, const int x, screen& screen)
+void shields::instance::hit(const bool from_above, const int x, playfield& playfield)
 {
     if (x >= _x && x < _x + 4) {
         const auto column = x - _x;
@@ -90,10 +125,20 @@ void shields::instance::hit(const bool from_above, const int x, screen& screen)
         const auto top_sprite = top_damage_sprites[column][damage];
         const auto bottom_sprite = bottom_damage_sprites[column][damage];
 
-        if (screen.at(_y, x) == shields::id && top_sprite != previous_top_sprite)
-            screen.write(_y, x, top_sprite, color::green, shields::id);
+        if (playfield.at(_y, x) == shields::id && top_sprite != previous_top_sprite)
+            playfield.write(_y, x, top_sprite, color::green, shields::id);
 
-        if (screen.at(_y + 1, x) == shields::id && bottom_sprite != previous_bottom_sprite)
-            screen.write(_y + 1, x, bottom_sprite, color::green, shields::id);
+        if (playfield.at(_y + 1, x) == shields::id && bottom_sprite != previous_bottom_sprite)
+            playfield.write(_y + 1, x, bottom_sprite, color::green, shields::id);
     }
 }
+
+shields::state shields::save() const
+{
+    return _state;
+}
+
+void shields::restore(const state& state)
+{
+    _state = state;
+}
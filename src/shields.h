@@ -4,33 +4,53 @@
 
 #pragma once
 
+#include "playfield.h"
+
 #include <array>
 
-class screen;
+class glyph_set;
 
-class shields {
+class shields : public overwrite_listener {
 public:
     static constexpr int id = 'S';
     static constexpr int row = 19;
 
-    shields(screen& screen);
+    static glyph_set glyphs();
+
+    shields(playfield& playfield);
+    shields(const shields&) = delete;
+    shields& operator=(const shields&) = delete;
+    ~shields();
     void reset();
     void update();
     void hit(const bool from_above, const int x);
+    void overwritten(const int y, const int x, const int id) override;
 
 private:
     class instance {
     public:
-        void reset(const int n, screen& screen);
-        void update(screen& screen);
-        void hit(const bool from_above, const int x, screen& screen);
+        void reset(const int n, playfield& playfield);
+        void update();
+        void hit(const bool from_above, const int x, playfield& playfield);
+        void overwritten(const int y, const int x);
 
     private:
         int _y = 0;
         int _x = 0;
         std::array<int, 4> _damage = {};
+        std::array<int, 4> _overwritten = {};
     };
 
-    screen& _screen;
-    std::array<instance, 4> _shields = {};
+public:
+    struct state {
+        std::array<instance, 4> shields = {};
+        bool overwrites_pending = false;
+    };
+
+    state save() const;
+    void restore(const state& state);
+
+private:
+    playfield& _playfield;
+    state _state;
 };
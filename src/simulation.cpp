@@ -0,0 +1,180 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "simulation.h"
+
+#include "stats.h"
+
+#include <algorithm>
+
+void simulation::set_stats(stats* stats)
+{
+    _stats = stats;
+}
+
+void simulation::start_level()
+{
+    _level++;
+    _frame = 0;
+
+    // The output is attributed to the objects responsible for it, for
+    // the statistics. Writes that carry an id are attributed by the id.
+    _playfield.set_source(output_source::other);
+    _playfield.reset();
+    _playfield.set_source(output_source::status);
+    _status.reset();
+    _playfield.set_source(output_source::shields);
+    _shields.reset();
+    _playfield.set_source(output_source::aliens);
+    _aliens.reset();
+    _playfield.set_source(output_source::missiles);
+    _missiles.reset();
+    _playfield.set_source(output_source::turret);
+    _turret.reset();
+    _playfield.set_source(output_source::laser);
+    _laser.reset();
+    _playfield.set_source(output_source::ufo);
+    _ufo.reset();
+}
+
+simulation::outcome simulation::step(controls& controls)
+{
+    const auto frame = _frame++;
+    _input_time.reset();
+
+    _playfield.set_source(output_source::aliens);
+    const auto aliens_ready = _aliens.init(frame, _level);
+    if (_stats) _stats->lap(stats::phase::alien_init);
+    if (!aliens_ready) return outcome::running;
+
+    const auto alien_points = _aliens.update(_turret);
+    _playfield.set_source(output_source::status);
+    _status.add_to_score(alien_points);
+    if (_aliens.landed()) _turret.hit();
+    if (_aliens.remaining() == 0 && !_turret.exploding()) {
+        _playfield.pause(30);
+        return outcome::level_cleared;
+    }
+    if (_stats) _stats->lap(stats::phase::aliens);
+
+    if (_aliens.remaining() < 8) _ufo.disable();
+    _playfield.set_source(output_source::ufo);
+    const auto ufo_points = _ufo.update(frame);
+    _playfield.set_source(output_source::status);
+    _status.add_to_score(ufo_points);
+    if (_stats) _stats->lap(stats::phase::ufo);
+
+    _playfield.set_source(output_source::shields);
+    _shields.update();
+    if (_stats) _stats->lap(stats::phase::shields);
+
+    constexpr auto start_frame = aliens::count + 73;
+    if (frame < start_frame) return outcome::running;
+
+    _playfield.set_source(output_source::missiles);
+    if (frame % 3 == 0) {
+        if (_aliens.can_fire() && _missiles.can_fire() && !_turret.exploding()) {
+            const auto [y, x] = _aliens.fire();
+            _missiles.fire(y, x);
+        }
+        _missiles.update(frame, [&](const auto hit_id, const auto x) {
+            if (hit_id == turret::id)
+                _turret.hit();
+            else if (hit_id == shields::id)
+                _shields.hit(true, x);
+        });
+    }
+    if (_stats) _stats->lap(stats::phase::missiles);
+
+    _playfield.set_source(output_source::turret);
+    if (_turret.exploding()) {
+        if (_turret.render_explosion()) {
+            _playfield.set_source(output_source::status);
+            if (_status.lose_life(_aliens.landed()))
+                return outcome::game_over;
+            _playfield.set_source(output_source::turret);
+            _turret.reset();
+            _turret.reveal();
+        }
+    } else {
+        if (frame == start_frame) {
+            _turret.reveal();
+        } else if (const auto move = controls.take_move()) {
+            if (move->key == key::right)
+                _turret.move_right();
+            else
+                _turret.move_left();
+            _input_time = move->time;
+        }
+
+        // A press while the laser is still in flight is consumed without
+        // firing, so it doesn't count as a shot, or as a latency sample.
+        if (!_aliens.exploding()) {
+            if (const auto fire = controls.take_fire(); fire && !_laser.active()) {
+                _playfield.set_source(output_source::laser);
+                _laser.fire(_turret.x());
+                _input_time = std::min(_input_time.value_or(fire->time), fire->time);
+            }
+        }
+    }
+    if (_stats) _stats->lap(stats::phase::turret);
+
+    _playfield.set_source(output_source::laser);
+    const auto hit_id = _laser.update();
+    if (hit_id == shields::id)
+        _shields.hit(false, _laser.x());
+    else if (hit_id == ufo::id) {
+        _playfield.set_source(output_source::ufo);
+        _ufo.kill();
+    } else if (hit_id >= 0 && hit_id < aliens::count)
+        _aliens.kill(hit_id);
+    if (_stats) _stats->lap(stats::phase::laser);
+    return outcome::running;
+}
+
+simulation::snapshot simulation::save() const
+{
+    auto snapshot = simulation::snapshot{};
+    snapshot.level = _level;
+    snapshot.frame = _frame;
+    snapshot.playfield = _playfield.save();
+    snapshot.status = _status.save();
+    snapshot.shields = _shields.save();
+    snapshot.aliens = _aliens.save();
+    snapshot.missiles = _missiles.save();
+    snapshot.turret = _turret.save();
+    snapshot.laser = _laser.save();
+    snapshot.ufo = _ufo.save();
+    return snapshot;
+}
+
+void simulation::restore(const snapshot& snapshot)
+{
+    _level = snapshot.level;
+    _frame = snapshot.frame;
+    _playfield.restore(snapshot.playfield);
+    _status.restore(snapshot.status);
+    _shields.restore(snapshot.shields);
+    _aliens.restore(snapshot.aliens);
+    _missiles.restore(snapshot.missiles);
+    _turret.restore(snapshot.turret);
+    _laser.restore(snapshot.laser);
+    _ufo.restore(snapshot.ufo);
+    _input_time.reset();
+}
+
+playfield& simulation::field()
+{
+    return _playfield;
+}
+
+int simulation::level() const
+{
+    return _level;
+}
+
+std::optional<input_event::clock::time_point> simulation::input_time() const
+{
+    return _input_time;
+}
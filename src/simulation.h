@@ -0,0 +1,77 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include "aliens.h"
+#include "input.h"
+#include "missiles.h"
+#include "playfield.h"
+#include "shields.h"
+#include "status.h"
+#include "turret.h"
+#include "ufo.h"
+
+#include <optional>
+#include <type_traits>
+
+class stats;
+
+// The complete game state, advanced one frame at a time. All collisions are
+// detected against the playfield, so the game can be simulated without a
+// screen, in which case the playfield changes are simply never rendered.
+// The phases of each step are only timed if stats are attached, so a
+// headless simulation never reads the clock.
+class simulation {
+public:
+    enum class outcome {
+        running,
+        level_cleared,
+        game_over
+    };
+
+    // Everything needed to resume the game from an earlier frame. There are
+    // no pointers, so a snapshot can be copied as a block, and restored in
+    // any simulation. The terminal side is saved separately by the screen.
+    struct snapshot {
+        int level = -1;
+        int frame = 0;
+        ::playfield::state playfield;
+        ::status::state status;
+        ::shields::state shields;
+        ::aliens::state aliens;
+        ::missiles::state missiles;
+        ::turret::state turret;
+        ::laser::state laser;
+        ::ufo::state ufo;
+    };
+
+    simulation() = default;
+    simulation(const simulation&) = delete;
+    simulation& operator=(const simulation&) = delete;
+    void start_level();
+    void set_stats(stats* stats);
+    outcome step(controls& controls);
+    snapshot save() const;
+    void restore(const snapshot& snapshot);
+    playfield& field();
+    int level() const;
+    std::optional<input_event::clock::time_point> input_time() const;
+
+private:
+    stats* _stats = nullptr;
+    playfield _playfield;
+    status _status{_playfield};
+    shields _shields{_playfield};
+    aliens _aliens{_playfield};
+    missiles _missiles{_playfield};
+    turret _turret{_playfield};
+    laser _laser{_playfield};
+    ufo _ufo{_playfield, _laser};
+    int _level = -1;
+    int _frame = 0;
+    std::optional<input_event::clock::time_point> _input_time;
+};
+
+static_assert(std::is_trivially_copyable_v<simulation::snapshot>);
@@ -0,0 +1,241 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "stats.h"
+
+#include "output.h"
+
+#include <algorithm>
+
+namespace {
+
+    constexpr auto phase_names = std::to_array({
+        "input",
+        "alien_init",
+        "aliens",
+        "ufo",
+        "shields",
+        "missiles",
+        "turret",
+        "laser",
+        "flush",
+        "pacing",
+    });
+    static_assert(phase_names.size() == stats::phase_count);
+
+    constexpr auto source_names = std::to_array({
+        "aliens",
+        "missiles",
+        "laser",
+        "turret",
+        "ufo",
+        "shields",
+        "status",
+        "other",
+    });
+    static_assert(source_names.size() == output_bytes::source_count);
+
+    // The phase timings are bucketed at 5us, which still covers half a frame
+    // at the default speed. The pacing wait usually takes up most of the
+    // frame, though, so that is bucketed more coarsely.
+    constexpr auto phase_bucket_width = 5;
+    constexpr auto pacing_bucket_width = 20;
+
+    int microseconds(const stats::clock::duration duration)
+    {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    }
+
+}  // namespace
+
+void stats::summary::add(const clock::duration duration)
+{
+    _count++;
+    _total += duration;
+    _max = std::max(_max, duration);
+}
+
+void stats::summary::report(output& out, const char* name) const
+{
+    const auto count = std::max(_count, 1LL);
+    out << name << " (us): count " << static_cast<int>(_count);
+    out << ", mean " << microseconds(_total / count);
+    out << ", max " << microseconds(_max) << '\n';
+}
+
+stats::histogram::histogram(const int bucket_width)
+    : _bucket_width{bucket_width}
+{
+}
+
+void stats::histogram::add(const int value)
+{
+    _buckets[std::clamp(value / _bucket_width, 0, bucket_count - 1)]++;
+    _count++;
+    _total += value;
+    _max = std::max(_max, value);
+}
+
+long long stats::histogram::count() const
+{
+    return _count;
+}
+
+long long stats::histogram::count_above(const int value) const
+{
+    // This is only exact if the value falls on a bucket boundary.
+    const auto first = std::clamp(value / _bucket_width + 1, 0, bucket_count);
+    auto count = 0LL;
+    for (auto bucket = first; bucket < bucket_count; bucket++)
+        count += _buckets[bucket];
+    return count;
+}
+
+int stats::histogram::mean() const
+{
+    return static_cast<int>(_total / std::max(_count, 1LL));
+}
+
+int stats::histogram::percentile(const int percent) const
+{
+    // Returns the upper bound of the first bucket that at least the given
+    // percentage of the samples fall into or below.
+    const auto target = (_count * percent + 99) / 100;
+    auto seen = 0LL;
+    for (auto bucket = 0; bucket < bucket_count; bucket++) {
+        seen += _buckets[bucket];
+        if (seen >= target && seen > 0)
+            return bucket == bucket_count - 1 ? _max : std::min((bucket + 1) * _bucket_width - 1, _max);
+    }
+    return _max;
+}
+
+int stats::histogram::max() const
+{
+    return _max;
+}
+
+void stats::histogram::report(output& out, const char* name) const
+{
+    out << "  " << name << ": count " << static_cast<int>(_count);
+    out << ", mean " << mean();
+    out << ", p50 " << percentile(50);
+    out << ", p99 " << percentile(99);
+    out << ", max " << _max << '\n';
+}
+
+stats::stats(const int fps)
+    : _frame_budget{std::chrono::duration_cast<clock::duration>(std::chrono::seconds{1}) / fps}
+{
+    _phase_histograms.fill(histogram{phase_bucket_width});
+    _phase_histograms[static_cast<int>(phase::pacing)] = histogram{pacing_bucket_width};
+}
+
+void stats::start_frame(const std::size_t output_size)
+{
+    _frame_start_size = output_size;
+    _frame_start = clock::now();
+    _lap_start = _frame_start;
+}
+
+void stats::lap(const phase phase)
+{
+    const auto now = clock::now();
+    const auto index = static_cast<int>(phase);
+    _phase_times[index] += now - _lap_start;
+    _phase_histograms[index].add(microseconds(now - _lap_start));
+    _lap_start = now;
+}
+
+void stats::end_frame(const std::size_t output_size)
+{
+    // The frame time covers everything up to the pacing wait, since that's
+    // what has to fit within the frame budget.
+    frame_bytes.add(static_cast<int>(output_size - _frame_start_size));
+    _frame_times.add(microseconds(clock::now() - _frame_start));
+}
+
+void stats::add_output(const int level, const output_bytes& bytes)
+{
+    const auto level_index = std::min(level, max_levels - 1);
+    _level_count = std::max(_level_count, level_index + 1);
+    for (auto i = 0; i < output_bytes::source_count; i++) {
+        _source_content[i] += bytes.content[i];
+        _source_overhead[i] += bytes.overhead[i];
+        _source_frame_max[i] = std::max(_source_frame_max[i], bytes.content[i] + bytes.overhead[i]);
+        _level_bytes[level_index][i] += bytes.content[i] + bytes.overhead[i];
+    }
+}
+
+long long stats::frame_count() const
+{
+    return frame_bytes.count();
+}
+
+stats::clock::duration stats::phase_time(const phase phase) const
+{
+    return _phase_times[static_cast<int>(phase)];
+}
+
+void stats::report(output& out) const
+{
+    input_latency.report(out, "Input to output latency");
+    const auto budget = microseconds(_frame_budget);
+    out << "Frame time (us): budget " << budget;
+    out << ", over budget " << static_cast<int>(_frame_times.count_above(budget)) << '\n';
+    _frame_times.report(out, "total");
+    frame_deviation.report(out, "start deviation");
+    out << "Phase time per frame (us):\n";
+    for (auto i = 0; i < phase_count; i++)
+        _phase_histograms[i].report(out, phase_names[i]);
+    out << "Bytes per frame:\n";
+    frame_bytes.report(out, "output");
+    report_output(out);
+}
+
+void stats::report_output(output& out) const
+{
+    // The overhead is the cursor movement and SGR changes needed to output
+    // each source's cells.
+    auto total = 0LL;
+    for (auto i = 0; i < output_bytes::source_count; i++)
+        total += _source_content[i] + _source_overhead[i];
+    const auto frames = std::max(frame_count(), 1LL);
+    out << "Bytes by source (content + overhead):\n";
+    for (auto i = 0; i < output_bytes::source_count; i++) {
+        const auto bytes = _source_content[i] + _source_overhead[i];
+        out << "  " << source_names[i] << ": " << static_cast<int>(_source_content[i]);
+        out << " + " << static_cast<int>(_source_overhead[i]);
+        out << ", " << static_cast<int>(bytes * 100 / std::max(total, 1LL)) << "%";
+        out << ", per frame mean " << static_cast<int>(bytes / frames);
+        out << ", max " << _source_frame_max[i] << '\n';
+    }
+    out << "Bytes by level:\n";
+    for (auto level = 0; level < _level_count; level++) {
+        const auto& bytes = _level_bytes[level];
+        auto level_total = 0LL;
+        for (const auto source_bytes : bytes)
+            level_total += source_bytes;
+        out << "  " << level + 1 << (level == max_levels - 1 ? "+" : "") << ": ";
+        out << static_cast<int>(level_total) << " (";
+        for (auto i = 0; i < output_bytes::source_count; i++) {
+            if (i > 0) out << ", ";
+            out << source_names[i] << ' ' << static_cast<int>(bytes[i]);
+        }
+        out << ")\n";
+    }
+}
+
+void stats::report_frames(output& out) const
+{
+    out << "Bytes per frame: mean " << frame_bytes.mean();
+    out << ", p99 " << frame_bytes.percentile(99);
+    out << ", max " << frame_bytes.max() << '\n';
+    const auto frames = std::max(frame_count(), 1LL);
+    out << "Time per frame (ns):\n";
+    for (auto i = 0; i < phase_count; i++) {
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(_phase_times[i]).count();
+        out << "  " << phase_names[i] << ": " << static_cast<int>(nanoseconds / frames) << '\n';
+    }
+}
@@ -0,0 +1,104 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include "playfield.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+class output;
+
+class stats {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // The parts of a frame that are timed separately. Each phase covers the
+    // time since the end of the previous one.
+    enum class phase {
+        input,
+        alien_init,
+        aliens,
+        ufo,
+        shields,
+        missiles,
+        turret,
+        laser,
+        flush,
+        pacing
+    };
+    static constexpr int phase_count = static_cast<int>(phase::pacing) + 1;
+
+    class summary {
+    public:
+        void add(const clock::duration duration);
+        void report(output& out, const char* name) const;
+
+    private:
+        long long _count = 0;
+        clock::duration _total = {};
+        clock::duration _max = {};
+    };
+
+    // A fixed-size histogram, so nothing needs to be allocated while a game
+    // is running. Values beyond the last bucket are clamped into it, but the
+    // true maximum is still tracked.
+    class histogram {
+    public:
+        static constexpr int bucket_count = 2048;
+
+        histogram(const int bucket_width = 1);
+        void add(const int value);
+        long long count() const;
+        long long count_above(const int value) const;
+        int mean() const;
+        int percentile(const int percent) const;
+        int max() const;
+        void report(output& out, const char* name) const;
+
+    private:
+        int _bucket_width;
+        std::array<int, bucket_count> _buckets = {};
+        long long _count = 0;
+        long long _total = 0;
+        int _max = 0;
+    };
+
+    stats(const int fps);
+
+    summary input_latency;
+    histogram frame_bytes{4};
+    // How late each frame started relative to its scheduled time (us).
+    histogram frame_deviation{20};
+
+    void start_frame(const std::size_t output_size);
+    void lap(const phase phase);
+    void end_frame(const std::size_t output_size);
+    void add_output(const int level, const output_bytes& bytes);
+    long long frame_count() const;
+    clock::duration phase_time(const phase phase) const;
+    void report(output& out) const;
+    void report_frames(output& out) const;
+    void report_output(output& out) const;
+
+private:
+    const clock::duration _frame_budget;
+    clock::time_point _frame_start = {};
+    clock::time_point _lap_start = {};
+    std::size_t _frame_start_size = 0;
+    std::array<clock::duration, phase_count> _phase_times = {};
+    std::array<histogram, phase_count> _phase_histograms;
+    histogram _frame_times{20};
+
+    // Levels beyond the last are counted together with it.
+    static constexpr int max_levels = 10;
+    using source_totals = std::array<long long, output_bytes::source_count>;
+    source_totals _source_content = {};
+    source_totals _source_overhead = {};
+    std::array<int, output_bytes::source_count> _source_frame_max = {};
+    std::array<source_totals, max_levels> _level_bytes = {};
+    int _level_count = 0;
+};
@@ -5,13 +5,17 @@
 #include "status.h"
 
 #include "engine.h"
-#include "screen.h"
+#include "font.h"
+#include "playfield.h"
 
-#include <string>
+#include <array>
 
 namespace {
 
     constexpr auto turret_sprite = "sz";
+    constexpr auto score_label = "SCORE ";
+    constexpr auto score_underline = '_';
+    constexpr char game_over_message[] = "GAME OVER";
 
     constexpr int extra_life_score = 1500;
 
@@ -20,8 +24,19 @@ namespace {
 
 }  // namespace
 
-status::status(screen& screen)
-    : _screen{screen}
+glyph_set status::glyphs()
+{
+    auto glyphs = glyph_set{};
+    glyphs.add(turret_sprite);
+    glyphs.add(score_label);
+    glyphs.add({&score_underline, 1});
+    glyphs.add("0123456789");
+    glyphs.add(game_over_message);
+    return glyphs;
+}
+
+status::status(playfield& playfield)
+    : _playfield{playfield}
 {
 }
 
@@ -29,28 +44,28 @@ void status::reset()
 {
     // MLTerm doesn't reset double-width lines correctly, so we need to
     // manually reset the GAME OVER line when restarting a level.
-    _screen.single_width(game_over_row);
-    _screen.double_width(score_row);
+    _playfield.single_width(game_over_row);
+    _playfield.double_width(score_row);
     _render_lives();
-    _screen.pause(1);
-    _screen.write(score_row, 19, "SCORE ", color::white);
+    _playfield.pause(1);
+    _playfield.write(score_row, 19, score_label, color::white);
     _render_score();
-    _screen.pause(1);
-    _screen.write(score_row - 1, 1, "", color::green);
+    _playfield.pause(1);
+    _playfield.write(score_row - 1, 1, "", color::green);
     for (auto i = engine::width; i-- > 0;) {
-        _screen.write('_');
+        _playfield.write(score_underline);
         if (i % (engine::width / 3) == 0)
-            _screen.pause(1);
+            _playfield.pause(1);
     }
 }
 
 void status::add_to_score(const int points)
 {
     if (points > 0) {
-        _score += points;
+        _state.score += points;
         _render_score();
-        if (_score >= extra_life_score && _score - points < extra_life_score) {
-            _lives++;
+        if (_state.score >= extra_life_score && _state.score - points < extra_life_score) {
+            _state.lives++;
             _render_lives();
         }
     }
@@ -58,10 +73,10 @@ void status::add_to_score(const int points)
 
 bool status::lose_life(const bool all)
 {
-    _lives -= (all ? _lives : 1);
+    _state.lives -= (all ? _state.lives : 1);
     _render_lives(true);
-    if (_lives > 0) {
-        _screen.pause(128);
+    if (_state.lives > 0) {
+        _playfield.pause(128);
         return false;
     } else {
         _render_game_over();
@@ -71,33 +86,45 @@ bool status::lose_life(const bool all)
 
 void status::_render_score()
 {
-    auto score_string = std::to_string(_score % 10000);
-    score_string.insert(0, 4 - score_string.length(), '0');
-    _screen.write(score_row, 25, score_string, color::white);
+    auto score_digits = std::array<char, 4>{};
+    auto score = _state.score;
+    for (auto i = score_digits.size(); i-- > 0; score /= 10)
+        score_digits[i] = '0' + score % 10;
+    _playfield.write(score_row, 25, {score_digits.data(), score_digits.size()}, color::white);
 }
 
 void status::_render_lives(const bool decreasing)
 {
-    _screen.write(score_row, 3, std::to_string(_lives), color::white);
-    _screen.write(' ');
+    _playfield.write(score_row, 3, static_cast<char>('0' + _state.lives % 10), color::white);
+    _playfield.write(' ');
     if (decreasing) {
-        if (_lives > 0)
-            _screen.write(score_row, 3 + _lives * 2, "  ");
+        if (_state.lives > 0)
+            _playfield.write(score_row, 3 + _state.lives * 2, "  ");
         else
-            _screen.write(score_row, 5, "            ");
+            _playfield.write(score_row, 5, "            ");
     } else {
-        for (auto i = 1; i < _lives; i++)
-            _screen.write(score_row, 3 + i * 2, turret_sprite, color::green);
+        for (auto i = 1; i < _state.lives; i++)
+            _playfield.write(score_row, 3 + i * 2, turret_sprite, color::green);
     }
 }
 
 void status::_render_game_over()
 {
-    _screen.clear_line(game_over_row);
-    _screen.double_width(game_over_row);
-    _screen.write(game_over_row, 11, "", color::red);
-    for (auto ch : "GAME OVER") {
-        _screen.write(ch);
-        _screen.pause(6);
+    _playfield.clear_line(game_over_row);
+    _playfield.double_width(game_over_row);
+    _playfield.write(game_over_row, 11, "", color::red);
+    for (auto ch : game_over_message) {
+        _playfield.write(ch);
+        _playfield.pause(6);
     }
 }
+
+status::state status::save() const
+{
+    return _state;
+}
+
+void status::restore(const state& state)
+{
+    _state = state;
+}
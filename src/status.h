@@ -4,21 +4,30 @@
 
 #pragma once
 
-class screen;
+class glyph_set;
+class playfield;
 
 class status {
 public:
-    status(screen& screen);
+    struct state {
+        int score = 0;
+        int lives = 3;
+    };
+
+    static glyph_set glyphs();
+
+    status(playfield& playfield);
     void reset();
     void add_to_score(const int points);
     bool lose_life(const bool all);
+    state save() const;
+    void restore(const state& state);
 
 private:
     void _render_score();
     void _render_lives(const bool decreasing = false);
     void _render_game_over();
 
-    screen& _screen;
-    int _score = 0;
-    int _lives = 3;
+    playfield& _playfield;
+    state _state;
 };
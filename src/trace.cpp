@@ -0,0 +1,54 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#include "trace.h"
+
+#include "os.h"
+#include "output.h"
+
+#include <algorithm>
+
+namespace {
+
+    int milliseconds(const startup_trace::clock::duration duration)
+    {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    }
+
+}  // namespace
+
+startup_trace::startup_trace()
+    : _start{clock::now()}, _last_time{_start}, _last_received{os::bytes_read()}
+{
+}
+
+void startup_trace::end_phase(const char* name, const std::size_t bytes_sent)
+{
+    // The byte counts are cumulative, so each phase gets the difference
+    // from the previous one.
+    const auto now = clock::now();
+    const auto bytes_received = os::bytes_read();
+    if (_phase_count < _phases.size()) {
+        auto& phase = _phases[_phase_count++];
+        phase.name = name;
+        phase.time = now - _last_time;
+        phase.bytes_sent = bytes_sent - std::min(_last_sent, bytes_sent);
+        phase.bytes_received = bytes_received - _last_received;
+    }
+    _last_time = now;
+    _last_sent = bytes_sent;
+    _last_received = bytes_received;
+}
+
+void startup_trace::report(output& out) const
+{
+    out << "Startup (ms, bytes sent, bytes received):\n";
+    for (auto i = 0u; i < _phase_count; i++) {
+        const auto& phase = _phases[i];
+        out << "  " << phase.name << ": " << milliseconds(phase.time);
+        out << ", " << static_cast<int>(phase.bytes_sent);
+        out << ", " << static_cast<int>(phase.bytes_received) << '\n';
+    }
+    out << "  total: " << milliseconds(_last_time - _start) << '\n';
+}
@@ -0,0 +1,37 @@
+// VT Invaders
+// Copyright (c) 2024 James Holderness
+// Distributed under the MIT License
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+class output;
+
+// Records the wall time and the bytes sent and received for each phase of
+// the startup, so we can see what is holding up the first frame.
+class startup_trace {
+public:
+    using clock = std::chrono::steady_clock;
+
+    startup_trace();
+    void end_phase(const char* name, const std::size_t bytes_sent = 0);
+    void report(output& out) const;
+
+private:
+    struct phase {
+        const char* name = nullptr;
+        clock::duration time = {};
+        std::size_t bytes_sent = 0;
+        std::size_t bytes_received = 0;
+    };
+
+    std::array<phase, 16> _phases = {};
+    std::size_t _phase_count = 0;
+    clock::time_point _start;
+    clock::time_point _last_time;
+    std::size_t _last_sent = 0;
+    std::size_t _last_received = 0;
+};
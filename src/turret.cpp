@@ -5,7 +5,8 @@
 #include "turret.h"
 
 #include "engine.h"
-#include "screen.h"
+#include "font.h"
+#include "playfield.h"
 
 #include <array>
 
@@ -20,16 +21,24 @@ namespace {
 
 }  // namespace
 
-turret::turret(screen& screen)
-    : _screen{screen}
+glyph_set turret::glyphs()
+{
+    auto glyphs = glyph_set{};
+    glyphs.add(turret_sprite);
+    glyphs.add(explosion_sprites);
+    return glyphs;
+}
+
+turret::turret(playfield& playfield)
+    : _playfield{playfield}
 {
 }
 
 void turret::reset()
 {
-    _y = row;
-    _x = left_boundary;
-    _dead = false;
+    _state.y = row;
+    _state.x = left_boundary;
+    _state.dead = false;
 }
 
 void turret::reveal()
@@ -39,109 +48,141 @@ void turret::reveal()
 
 void turret::move_left()
 {
-    if (_x > left_boundary) {
-        _x--;
+    if (_state.x > left_boundary) {
+        _state.x--;
         _render();
-        _screen.write(_y, _x + 3, ' ');
+        _playfield.write(_state.y, _state.x + 3, ' ');
     }
 }
 
 void turret::move_right()
 {
-    if (_x + 1 < right_boundary) {
-        _screen.write(_y, _x, ' ');
-        _x++;
+    if (_state.x + 1 < right_boundary) {
+        _playfield.write(_state.y, _state.x, ' ');
+        _state.x++;
         _render();
     }
 }
 
 void turret::hit()
 {
-    if (!_dead) {
-        _dead = true;
-        _explosion_frame = 0;
+    if (!_state.dead) {
+        _state.dead = true;
+        _state.explosion_frame = 0;
     }
 }
 
 bool turret::render_explosion()
 {
     static constexpr auto explosion_frame_count = 55;
-    if (_explosion_frame % 5 == 0 && _explosion_frame < explosion_frame_count) {
-        const auto sprite_index = _explosion_frame / 5 % 2;
-        _screen.write(_y, _x, explosion_sprites[sprite_index], color::green, id);
-    } else if (_explosion_frame == explosion_frame_count) {
-        _screen.write(_y, _x, "   ");
+    if (_state.explosion_frame % 5 == 0 && _state.explosion_frame < explosion_frame_count) {
+        const auto sprite_index = _state.explosion_frame / 5 % 2;
+        _playfield.write(_state.y, _state.x, explosion_sprites[sprite_index], color::green, id);
+    } else if (_state.explosion_frame == explosion_frame_count) {
+        _playfield.write(_state.y, _state.x, "   ");
     }
-    return _explosion_frame++ == explosion_frame_count;
+    return _state.explosion_frame++ == explosion_frame_count;
 }
 
 bool turret::exploding() const
 {
-    return _dead;
+    return _state.dead;
 }
 
 int turret::x() const
 {
-    return _x + 1;
+    return _state.x + 1;
+}
+
+turret::state turret::save() const
+{
+    return _state;
+}
+
+void turret::restore(const state& state)
+{
+    _state = state;
 }
 
 void turret::_render()
 {
-    _screen.write(_y, _x, turret_sprite, color::green, id);
+    _playfield.write(_state.y, _state.x, turret_sprite, color::green, id);
 }
 
-laser::laser(screen& screen)
-    : _screen{screen}
+glyph_set laser::glyphs()
+{
+    auto glyphs = glyph_set{};
+    glyphs.add(laser_sprites);
+    return glyphs;
+}
+
+laser::laser(playfield& playfield)
+    : _playfield{playfield}
 {
 }
 
 void laser::reset()
 {
-    _active = false;
+    _state.active = false;
 }
 
 void laser::fire(const int x)
 {
-    if (!_active) {
-        _active = true;
-        _x = x;
-        _y = turret::row - 1;
-        _phase = 0;
-        _shots_fires++;
+    if (!_state.active) {
+        _state.active = true;
+        _state.x = x;
+        _state.y = turret::row - 1;
+        _state.phase = 0;
+        _state.shots_fired++;
     }
 }
 
 int laser::update()
 {
-    if (!_active) return screen::empty;
+    if (!_state.active) return playfield::empty;
 
-    if (_y == 1 && _phase >= 1) {
-        if (_phase == 1 || _phase == 2)
-            _screen.write(_y, _x, laser_sprites[_phase], color::red);
-        else if (_phase == 17)
-            _screen.write(_y, _x, ' ');
-        _active = (++_phase < 18);
-        return screen::empty;
+    if (_state.y == 1 && _state.phase >= 1) {
+        if (_state.phase == 1 || _state.phase == 2)
+            _playfield.write(_state.y, _state.x, laser_sprites[_state.phase], color::red);
+        else if (_state.phase == 17)
+            _playfield.write(_state.y, _state.x, ' ');
+        _state.active = (++_state.phase < 18);
+        return playfield::empty;
     }
 
-    const auto hit_id = _screen.at(_y, _x);
-    if (hit_id == screen::empty)
-        _screen.write(_y, _x, laser_sprites[_phase], screen::color_for_row(_y));
-    if (_phase == 0 && _screen.at(_y + 1, _x) == screen::empty)
-        _screen.write(_y + 1, _x, ' ');
+    const auto hit_id = _playfield.at(_state.y, _state.x);
+    if (hit_id == playfield::empty)
+        _playfield.write(_state.y, _state.x, laser_sprites[_state.phase], playfield::color_for_row(_state.y));
+    if (_state.phase == 0 && !_playfield.occupied(_state.y + 1, _state.x))
+        _playfield.write(_state.y + 1, _state.x, ' ');
 
-    _y -= _phase;
-    _phase ^= 1;
-    _active = (hit_id == screen::empty);
+    _state.y -= _state.phase;
+    _state.phase ^= 1;
+    _state.active = (hit_id == playfield::empty);
     return hit_id;
 }
 
+bool laser::active() const
+{
+    return _state.active;
+}
+
 int laser::x() const
 {
-    return _x;
+    return _state.x;
 }
 
 int laser::shots_fired() const
 {
-    return _shots_fires;
+    return _state.shots_fired;
+}
+
+laser::state laser::save() const
+{
+    return _state;
+}
+
+void laser::restore(const state& state)
+{
+    _state = state;
 }
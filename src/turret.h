@@ -4,14 +4,24 @@
 
 #pragma once
 
-class screen;
+class glyph_set;
+class playfield;
 
 class turret {
 public:
     static constexpr int id = 'T';
     static constexpr int row = 22;
 
-    turret(screen& screen);
+    struct state {
+        int x = 0;
+        int y = 0;
+        bool dead = false;
+        int explosion_frame = 0;
+    };
+
+    static glyph_set glyphs();
+
+    turret(playfield& playfield);
     void reset();
     void reveal();
     void move_left();
@@ -20,32 +30,39 @@ public:
     bool render_explosion();
     bool exploding() const;
     int x() const;
+    state save() const;
+    void restore(const state& state);
 
 private:
     void _render();
 
-    screen& _screen;
-    int _x = 0;
-    int _y = 0;
-    bool _dead = false;
-    int _explosion_frame = 0;
+    playfield& _playfield;
+    state _state;
 };
 
 class laser {
 public:
-    laser(screen& screen);
+    struct state {
+        int x = 0;
+        int y = 0;
+        int phase = 0;
+        bool active = false;
+        int shots_fired = 0;
+    };
+
+    static glyph_set glyphs();
+
+    laser(playfield& playfield);
     void reset();
     void fire(const int x);
     int update();
+    bool active() const;
     int x() const;
     int shots_fired() const;
+    state save() const;
+    void restore(const state& state);
 
 private:
-    screen& _screen;
-
-    int _x = 0;
-    int _y = 0;
-    int _phase = 0;
-    bool _active = false;
-    int _shots_fires = 0;
+    playfield& _playfield;
+    state _state;
 };
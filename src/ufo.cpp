@@ -5,11 +5,12 @@
 #include "ufo.h"
 
 #include "engine.h"
-#include "screen.h"
+#include "font.h"
+#include "playfield.h"
 #include "turret.h"
 
 #include <array>
-#include <string>
+#include <string_view>
 
 namespace {
 
@@ -23,16 +24,26 @@ namespace {
 
 }  // namespace
 
-ufo::ufo(screen& screen, const laser& laser)
-    : _screen{screen}, _laser{laser}
+glyph_set ufo::glyphs()
+{
+    // The points are also shown when the UFO is hit.
+    auto glyphs = glyph_set{};
+    glyphs.add(ufo_sprite);
+    glyphs.add(explosion_sprite);
+    glyphs.add("0123456789");
+    return glyphs;
+}
+
+ufo::ufo(playfield& playfield, const laser& laser)
+    : _playfield{playfield}, _laser{laser}
 {
 }
 
 void ufo::reset()
 {
-    _active = false;
-    _dead = false;
-    _disabled = false;
+    _state.active = false;
+    _state.dead = false;
+    _state.disabled = false;
 }
 
 int ufo::update(const int frame)
@@ -40,68 +51,84 @@ int ufo::update(const int frame)
     // First UFO appears around 35 seconds, then every 25 seconds thereafter.
     constexpr auto first_frame = 35 * 60;
     constexpr auto interval = 25 * 60;
-    if (_dead) {
-        if (_active) {
+    if (_state.dead) {
+        if (_state.active) {
             // The score is rendered as double width, so a 3 digit value is
             // actually 6 columns, and a 2 digit value is 4 columns. Since the
             // UFO itself is 4 columns, a 3 digit score will align best when
             // the UFO is in an odd column, and a 2 digit score will look best
             // with an even column. If we aren't on an ideal column, we move
             // one additional step in the direction we were going.
-            if ((_points_earned >= 100) != (_x % 2 == 0)) _x += _x_delta;
-            _screen.clear_line(_y);
-            _screen.write(_y, _x, explosion_sprite, color::red);
-            _death_frame = frame;
-            _active = false;
-        } else if (frame == _death_frame + 21) {
-            _screen.clear_line(_y);
-            _screen.double_width(_y);
-            _screen.write(_y, (_x + 1) / 2, std::to_string(_points_earned), color::red);
-            return _points_earned;
-        } else if (frame == _death_frame + 93) {
-            _screen.clear_line(_y);
-            _screen.single_width(_y);
-            _dead = false;
+            if ((_state.points_earned >= 100) != (_state.x % 2 == 0)) _state.x += _state.x_delta;
+            _playfield.clear_line(_state.y);
+            _playfield.write(_state.y, _state.x, explosion_sprite, color::red);
+            _state.death_frame = frame;
+            _state.active = false;
+        } else if (frame == _state.death_frame + 21) {
+            _playfield.clear_line(_state.y);
+            _playfield.double_width(_state.y);
+            auto points_digits = std::array<char, 3>{};
+            auto points = _state.points_earned;
+            auto i = points_digits.size();
+            for (; points > 0; points /= 10)
+                points_digits[--i] = '0' + points % 10;
+            const auto points_string = std::string_view{&points_digits[i], points_digits.size() - i};
+            _playfield.write(_state.y, (_state.x + 1) / 2, points_string, color::red);
+            return _state.points_earned;
+        } else if (frame == _state.death_frame + 93) {
+            _playfield.clear_line(_state.y);
+            _playfield.single_width(_state.y);
+            _state.dead = false;
         }
-    } else if (_active) {
+    } else if (_state.active) {
         // The UFO should really only move once every 6 frames, but that
         // feels a bit jerky, so we've made it slightly faster.
         if (frame % 5 == 0) {
-            _x += _x_delta;
-            if (_x < left_boundary || _x > right_boundary) {
-                _active = false;
-                _screen.write(_y, _x - _x_delta, "    ");
-            } else if (_x_delta < 0) {
-                _screen.write(_y, _x, ufo_sprite, color::red, id);
-                _screen.write(_y, _x + 4, ' ');
+            _state.x += _state.x_delta;
+            if (_state.x < left_boundary || _state.x > right_boundary) {
+                _state.active = false;
+                _playfield.write(_state.y, _state.x - _state.x_delta, "    ");
+            } else if (_state.x_delta < 0) {
+                _playfield.write(_state.y, _state.x, ufo_sprite, color::red, id);
+                _playfield.write(_state.y, _state.x + 4, ' ');
             } else {
-                _screen.write(_y, _x - 1, ' ');
-                _screen.write(_y, _x, ufo_sprite, color::red, id);
+                _playfield.write(_state.y, _state.x - 1, ' ');
+                _playfield.write(_state.y, _state.x, ufo_sprite, color::red, id);
             }
         }
-    } else if (frame >= first_frame && (frame - first_frame) % interval == 0 && !_disabled) {
+    } else if (frame >= first_frame && (frame - first_frame) % interval == 0 && !_state.disabled) {
         // The direction of movement depends on the shots fired so far.
         const auto left_to_right = (_laser.shots_fired() % 2 == 0);
-        _active = true;
-        _dead = false;
-        _y = ufo::row;
-        _x = left_to_right ? left_boundary : right_boundary;
-        _x_delta = left_to_right ? 1 : -1;
-        _screen.write(_y, _x, ufo_sprite, color::red, id);
+        _state.active = true;
+        _state.dead = false;
+        _state.y = ufo::row;
+        _state.x = left_to_right ? left_boundary : right_boundary;
+        _state.x_delta = left_to_right ? 1 : -1;
+        _playfield.write(_state.y, _state.x, ufo_sprite, color::red, id);
     }
     return 0;
 }
 
 void ufo::disable()
 {
-    _disabled = true;
+    _state.disabled = true;
 }
 
 void ufo::kill()
 {
-    if (_active && !_dead) {
+    if (_state.active && !_state.dead) {
         // The points earned depends on the number of shots fired so far.
-        _points_earned = possible_points[_laser.shots_fired() % possible_points.size()];
-        _dead = true;
+        _state.points_earned = possible_points[_laser.shots_fired() % possible_points.size()];
+        _state.dead = true;
     }
 }
+
+ufo::state ufo::save() const
+{
+    return _state;
+}
+
+void ufo::restore(const state& state)
+{
+    _state = state;
+}
@@ -5,28 +5,37 @@
 #pragma once
 
 class laser;
-class screen;
+class glyph_set;
+class playfield;
 
 class ufo {
 public:
     static constexpr int id = 'U';
     static constexpr int row = 2;
 
-    ufo(screen& screen, const laser& laser);
+    struct state {
+        int x = 0;
+        int y = 0;
+        int x_delta = 1;
+        bool active = false;
+        bool dead = false;
+        bool disabled = false;
+        int death_frame = 0;
+        int points_earned = 0;
+    };
+
+    static glyph_set glyphs();
+
+    ufo(playfield& playfield, const laser& laser);
     void reset();
     int update(const int frame);
     void disable();
     void kill();
+    state save() const;
+    void restore(const state& state);
 
 private:
-    screen& _screen;
+    playfield& _playfield;
     const laser& _laser;
-    int _x = 0;
-    int _y = 0;
-    int _x_delta = 1;
-    bool _active = false;
-    bool _dead = false;
-    bool _disabled = false;
-    int _death_frame = 0;
-    int _points_earned = 0;
+    state _state;
 };